@@ -0,0 +1,156 @@
+#include "Attacks.h"
+
+Bitboard pawnAttackTable[COLOR_NB][64];
+Bitboard knightAttackTable[64];
+Bitboard kingAttackTable[64];
+Magic bishopMagics[64];
+Magic rookMagics[64];
+Bitboard betweenTable[64][64];
+Bitboard lineTable[64][64];
+
+static Bitboard bishopTable[0x1480];
+static Bitboard rookTable[0x19000];
+
+static const int bishopDirections[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+static const int rookDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+// Squares reached by single steps from sq, skipping steps that leave the board.
+static Bitboard leaperAttacks(int sq, const int steps[][2], int count) {
+    Bitboard attacks = 0;
+    for (int i = 0; i < count; ++i) {
+        int f = fileOf(sq) + steps[i][0];
+        int r = rankOf(sq) + steps[i][1];
+        if (f >= 0 && f < 8 && r >= 0 && r < 8)
+            attacks |= squareBB(makeSquare(f, r));
+    }
+    return attacks;
+}
+
+// Reference ray walk, only used while building the magic tables.
+static Bitboard slidingAttacks(int sq, Bitboard occupied, const int directions[4][2]) {
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; ++d) {
+        int f = fileOf(sq) + directions[d][0];
+        int r = rankOf(sq) + directions[d][1];
+        while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+            Bitboard b = squareBB(makeSquare(f, r));
+            attacks |= b;
+            if (occupied & b)
+                break;
+            f += directions[d][0];
+            r += directions[d][1];
+        }
+    }
+    return attacks;
+}
+
+// xorshift64* generator; a fixed seed keeps the magic search deterministic.
+static uint64_t nextRandom(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+static void initMagics(Magic magics[64], Bitboard* table, const int directions[4][2]) {
+    static Bitboard occupancy[4096];
+    static Bitboard reference[4096];
+    static int epoch[4096];
+
+    // Per-rank seeds known to find magics quickly with this generator
+    const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+    for (int sq = 0; sq < 64; ++sq) {
+        Magic& m = magics[sq];
+        uint64_t seed = seeds[rankOf(sq)];
+
+        // Edge squares never block anything beyond them, so leave them out of the mask
+        Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~rankBB(rankOf(sq)))
+                       | ((FILE_A_BB | FILE_H_BB) & ~fileBB(fileOf(sq)));
+        m.mask = slidingAttacks(sq, 0, directions) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = (sq == 0) ? table : magics[sq - 1].attacks + (1u << (64 - magics[sq - 1].shift));
+
+        // Enumerate every subset of the mask (Carry-Rippler trick)
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = slidingAttacks(sq, b, directions);
+#if defined(USE_PEXT)
+            m.attacks[m.index(b)] = reference[size];
+#endif
+            ++size;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+#if !defined(USE_PEXT)
+        for (int i = 0; i < size; ++i)
+            epoch[i] = 0;
+
+        // Try sparse random numbers until one maps every subset without a harmful collision
+        for (int attempt = 1, i = 0; i < size; ++attempt) {
+            do {
+                m.magic = nextRandom(seed) & nextRandom(seed) & nextRandom(seed);
+            } while (popCount((m.magic * m.mask) >> 56) < 6);
+
+            for (i = 0; i < size; ++i) {
+                unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+static void initAttacks() {
+    const int knightSteps[8][2] = {
+        {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
+        {1, -2},  {1, 2},  {2, -1},  {2, 1}
+    };
+    const int kingSteps[8][2] = {
+        {-1, -1}, {-1, 0}, {-1, 1},
+        {0, -1},           {0, 1},
+        {1, -1},  {1, 0},  {1, 1}
+    };
+    const int whitePawnSteps[2][2] = {{-1, 1}, {1, 1}};
+    const int blackPawnSteps[2][2] = {{-1, -1}, {1, -1}};
+
+    for (int sq = 0; sq < 64; ++sq) {
+        knightAttackTable[sq] = leaperAttacks(sq, knightSteps, 8);
+        kingAttackTable[sq] = leaperAttacks(sq, kingSteps, 8);
+        pawnAttackTable[WHITE][sq] = leaperAttacks(sq, whitePawnSteps, 2);
+        pawnAttackTable[BLACK][sq] = leaperAttacks(sq, blackPawnSteps, 2);
+    }
+
+    initMagics(bishopMagics, bishopTable, bishopDirections);
+    initMagics(rookMagics, rookTable, rookDirections);
+
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            betweenTable[a][b] = lineTable[a][b] = 0;
+            if (a == b)
+                continue;
+
+            if (bishopAttacks(a, 0) & squareBB(b)) {
+                lineTable[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                betweenTable[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            } else if (rookAttacks(a, 0) & squareBB(b)) {
+                lineTable[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                betweenTable[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
+
+// Fill the tables before main() so lookups never need an initialisation check
+namespace {
+struct AttackTablesInit {
+    AttackTablesInit() { initAttacks(); }
+} attackTablesInit;
+}
@@ -0,0 +1,75 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+// Attack sets for every piece type, expressed as bitboards.
+//
+// Leaper attacks come from tables filled once at startup. Slider attacks use
+// fancy magic bitboards, or BMI2 PEXT indexing when built with USE_PEXT.
+
+#include "Bitboard.h"
+#include "Position.h"
+
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+struct Magic {
+    Bitboard mask;      // relevant occupancy, board edges excluded
+    Bitboard magic;
+    Bitboard* attacks;  // slice of the shared attack table for this square
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#if defined(USE_PEXT)
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Bitboard pawnAttackTable[COLOR_NB][64];
+extern Bitboard knightAttackTable[64];
+extern Bitboard kingAttackTable[64];
+extern Magic bishopMagics[64];
+extern Magic rookMagics[64];
+extern Bitboard betweenTable[64][64];
+extern Bitboard lineTable[64][64];
+
+inline Bitboard pawnAttacks(Color c, int sq) { return pawnAttackTable[c][sq]; }
+inline Bitboard knightAttacks(int sq) { return knightAttackTable[sq]; }
+inline Bitboard kingAttacks(int sq) { return kingAttackTable[sq]; }
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic& m = bishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic& m = rookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+// Squares strictly between a and b when they share a rank, file or diagonal, else empty.
+inline Bitboard betweenBB(int a, int b) { return betweenTable[a][b]; }
+
+// The whole line through a and b (edge to edge) when they are aligned, else empty.
+inline Bitboard lineBB(int a, int b) { return lineTable[a][b]; }
+
+// Attacks of a non-pawn piece type standing on sq.
+inline Bitboard attacksFrom(PieceType pt, int sq, Bitboard occupied) {
+    switch (pt) {
+    case KNIGHT: return knightAttacks(sq);
+    case BISHOP: return bishopAttacks(sq, occupied);
+    case ROOK:   return rookAttacks(sq, occupied);
+    case QUEEN:  return queenAttacks(sq, occupied);
+    case KING:   return kingAttacks(sq);
+    default:     return 0;
+    }
+}
+
+#endif // ATTACKS_H
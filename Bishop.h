@@ -7,8 +7,6 @@
 class Bishop : public ChessPiece{
 public:
     Bishop(PieceColor color, int row, int col);
-
-    QVector<QPair<int, int>> getValidMoves(const QVector<QVector<ChessPiece*>> &board) override;
 };
 
 
@@ -0,0 +1,73 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+// Qt-free bitboard primitives shared by the headless rules core.
+// Squares are numbered a1 = 0 ... h8 = 63 (little-endian rank-file mapping).
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef uint64_t Bitboard;
+
+const int NO_SQUARE = 64;
+
+const Bitboard FILE_A_BB = 0x0101010101010101ULL;
+const Bitboard FILE_H_BB = FILE_A_BB << 7;
+const Bitboard RANK_1_BB = 0xFFULL;
+const Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+inline int makeSquare(int file, int rank) { return rank * 8 + file; }
+inline int fileOf(int sq) { return sq & 7; }
+inline int rankOf(int sq) { return sq >> 3; }
+
+// The GUI board stores row 0 as Black's back rank (rank 8) and col 0 as the a-file.
+inline int squareFromRowCol(int row, int col) { return (7 - row) * 8 + col; }
+inline int rowOf(int sq) { return 7 - (sq >> 3); }
+inline int colOf(int sq) { return sq & 7; }
+
+inline Bitboard squareBB(int sq) { return 1ULL << sq; }
+inline Bitboard fileBB(int file) { return FILE_A_BB << file; }
+inline Bitboard rankBB(int rank) { return RANK_1_BB << (8 * rank); }
+
+inline int popCount(Bitboard b) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// Index of the least significant set bit; b must be non-zero.
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, b);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+// Index of the most significant set bit; b must be non-zero.
+inline int msb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, b);
+    return static_cast<int>(idx);
+#else
+    return 63 ^ __builtin_clzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+inline bool moreThanOne(Bitboard b) { return (b & (b - 1)) != 0; }
+
+#endif // BITBOARD_H
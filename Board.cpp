@@ -2,10 +2,13 @@
 #include "Board.h"
 #include "Pawn.h"
 #include "Bishop.h"
-#include "Knight.h"
-#include "Rook.h"
-#include "Queen.h"
-#include "King.h"
+#include "knight.h"
+#include "rook.h"
+#include "queen.h"
+#include "king.h"
+#include "Draw.h"
+#include "MoveGen.h"
+#include "Pgn.h"
 // Qt graphics and utilities
 #include <QGraphicsRectItem>
 #include <QGraphicsPixmapItem>
@@ -13,6 +16,7 @@
 #include <QGraphicsView>
 #include <QApplication>
 #include <QBrush>
+#include <QPen>
 #include <QPixmap>
 #include <QDebug>
 
@@ -22,6 +26,7 @@ Board::Board(int border, int squareSize)
     currentPlayer = ChessPiece::White;
 
     board.resize(8, QVector<ChessPiece*>(8, nullptr));
+    history.reserve(512);
     clearCheckHighlight();
 
     //load and display board background
@@ -49,41 +54,99 @@ Board::~Board() {
             delete board[row][col];
         }
     }
+    clearHistory();
+}
+
+static Color toCoreColor(ChessPiece::PieceColor color) {
+    return (color == ChessPiece::White) ? WHITE : BLACK;
+}
+
+// Map a scene item onto the headless piece code
+static Piece toCorePiece(const ChessPiece* piece) {
+    // Indexed by ChessPiece::PieceType
+    static const PieceType types[] = {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+    return makePiece(toCoreColor(piece->getColor()), types[piece->getType()]);
+}
+
+static ChessPiece* createPieceItem(Piece pc, int row, int col) {
+    ChessPiece::PieceColor color = (colorOf(pc) == WHITE) ? ChessPiece::White : ChessPiece::Black;
+    switch (typeOf(pc)) {
+    case PAWN:   return new Pawn(color, row, col);
+    case KNIGHT: return new Knight(color, row, col);
+    case BISHOP: return new Bishop(color, row, col);
+    case ROOK:   return new Rook(color, row, col);
+    case QUEEN:  return new Queen(color, row, col);
+    case KING:   return new King(color, row, col);
+    default:     return nullptr;
+    }
 }
 
 void Board::setupInitialPosition() {
-    // --- White pieces (bottom side) ---
-    // Row 7: Rook, Knight, Bishop, Queen, King, Bishop, Knight, Rook
-    addPiece(new Rook(ChessPiece::White, 7, 0));
-    addPiece(new Knight(ChessPiece::White, 7, 1));
-    addPiece(new Bishop(ChessPiece::White, 7, 2));
-    addPiece(new Queen(ChessPiece::White, 7, 3));
-    addPiece(new King(ChessPiece::White, 7, 4));
-    addPiece(new Bishop(ChessPiece::White, 7, 5));
-    addPiece(new Knight(ChessPiece::White, 7, 6));
-    addPiece(new Rook(ChessPiece::White, 7, 7));
+    position.setStartPosition();
+    rebuildFromPosition();
+}
+
+FenError Board::loadFen(std::string_view fen) {
+    Position parsed;
+    FenError error = parsed.fromFen(fen);
+    if (!error.ok())
+        return error;
+
+    resetSelection();
+    position = parsed;
+    rebuildFromPosition();
+    updateCheckHighlight();
+    return error;
+}
 
-    // Row 6: White pawns
-    for (int col = 0; col < 8; ++col) {
-        addPiece(new Pawn(ChessPiece::White, 6, col));
+QString Board::getFen() const {
+    char buf[MAX_FEN_LENGTH];
+    return QString::fromLatin1(buf, static_cast<int>(position.toFen(buf)));
+}
+
+QString Board::getPgn() const {
+    PgnGame game;
+    game.start = startPosition;
+    for (const PlayedMove& record : history)
+        game.moves.push_back(record.move);
+
+    std::string text;
+    writePgn(text, game);
+    return QString::fromStdString(text);
+}
+
+// Recreate every scene item from the headless position
+void Board::rebuildFromPosition() {
+    closePromotionChooser();
+    clearHistory();
+    startPosition = position;
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            if (board[r][c]) {
+                removeItem(board[r][c]);
+                delete board[r][c];
+                board[r][c] = nullptr;
+            }
+        }
     }
 
+    currentPlayer = (position.sideToMove() == WHITE) ? ChessPiece::White : ChessPiece::Black;
 
-    // --- Black pieces (top side) ---
-    // Row 0: Rook, Knight, Bishop, Queen, King, Bishop, Knight, Rook
-    addPiece(new Rook(ChessPiece::Black, 0, 0));
-    addPiece(new Knight(ChessPiece::Black, 0, 1));
-    addPiece(new Bishop(ChessPiece::Black, 0, 2));
-    addPiece(new Queen(ChessPiece::Black, 0, 3));
-    addPiece(new King(ChessPiece::Black, 0, 4));
-    addPiece(new Bishop(ChessPiece::Black, 0, 5));
-    addPiece(new Knight(ChessPiece::Black, 0, 6));
-    addPiece(new Rook(ChessPiece::Black, 0, 7));
+    for (int sq = 0; sq < 64; ++sq) {
+        Piece pc = position.pieceOn(sq);
+        if (pc == NO_PIECE)
+            continue;
 
-    // Row 1: Black pawns
-    for (int col = 0; col < 8; ++col) {
-        addPiece(new Pawn(ChessPiece::Black, 1, col));
+        int row = rowOf(sq);
+        int col = colOf(sq);
+        ChessPiece* piece = createPieceItem(pc, row, col);
+
+        board[row][col] = piece;
+        piece->updateGraphicsPosition(border, squareSize);
+        addItem(piece);
     }
+
+    emit turnChanged(currentPlayer);
 }
 
 //Add Pieces
@@ -104,6 +167,9 @@ void Board::addPiece(ChessPiece* piece) {
     }
 
     board[row][col] = piece;
+    position.putPiece(toCorePiece(piece), squareFromRowCol(row, col));
+    // A hand-placed piece invalidates the recorded moves
+    clearHistory();
     piece->updateGraphicsPosition(border, squareSize);
     addItem(piece);
 }
@@ -114,6 +180,22 @@ ChessPiece* Board::getPiece(int row, int col) const {
     return board[row][col];
 }
 
+const Position& Board::getPosition() const {
+    return position;
+}
+
+uint64_t Board::getZobristKey() const {
+    return position.key();
+}
+
+std::vector<uint64_t> Board::getGameKeys() const {
+    std::vector<uint64_t> keys;
+    keys.reserve(history.size());
+    for (const PlayedMove& record : history)
+        keys.push_back(record.undo.key);
+    return keys;
+}
+
 void Board::resetSelection() {
     if (selectedPiece)
         selectedPiece->setZValue(0);
@@ -132,6 +214,11 @@ void Board::mousePressEvent(QGraphicsSceneMouseEvent* event) {
     int clickedRow = qBound(0, static_cast<int>((pos.y() - border) / squareSize), 7);
     int clickedCol = qBound(0, static_cast<int>((pos.x() - border) / squareSize), 7);
 
+    if (isChoosingPromotion()) {
+        choosePromotion(clickedRow, clickedCol);
+        return;
+    }
+
     QGraphicsItem* item = itemAt(pos, QTransform());
     ChessPiece* piece = dynamic_cast<ChessPiece*>(item);
 
@@ -168,7 +255,7 @@ void Board::mousePressEvent(QGraphicsSceneMouseEvent* event) {
 }
 
 void Board::mouseMoveEvent(QGraphicsSceneMouseEvent* event) {
-    if (!selectedPiece || !(event->buttons() & Qt::LeftButton))
+    if (!selectedPiece || isChoosingPromotion() || !(event->buttons() & Qt::LeftButton))
         return;
 
     QPointF delta = event->scenePos() - selectedPiece->pos();
@@ -183,7 +270,7 @@ void Board::mouseMoveEvent(QGraphicsSceneMouseEvent* event) {
 }
 
 void Board::mouseReleaseEvent(QGraphicsSceneMouseEvent* event) {
-    if (!selectedPiece || event->button() != Qt::LeftButton)
+    if (!selectedPiece || isChoosingPromotion() || event->button() != Qt::LeftButton)
         return;
 
     selectedPiece->setZValue(0);
@@ -206,67 +293,235 @@ void Board::mouseReleaseEvent(QGraphicsSceneMouseEvent* event) {
 }
 
 void Board::movePiece(ChessPiece* piece, int newRow, int newCol) {
-    int oldRow = piece->getRow();
-    int oldCol = piece->getCol();
-
-    if (abs(newCol - oldCol) == 2) {
-        if (tryCastling(piece, newRow, newCol)) {
-            switchTurn();
-            updateCheckHighlight();
-            if (isCheckmate(currentPlayer)) {
-                emit checkmate(currentPlayer);
-            }
-            return; // castling move done, no further move needed
+    int from = squareFromRowCol(piece->getRow(), piece->getCol());
+    int to = squareFromRowCol(newRow, newCol);
+
+    // Match the drop against the generator's moves; a promotion waits for
+    // the player to pick the piece
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (Move m : moves) {
+        if (m.from() != from || m.to() != to)
+            continue;
+        if (m.isPromotion()) {
+            piece->updateGraphicsPosition(border, squareSize);
+            showPromotionChooser(from, to);
+        } else {
+            playMove(m);
         }
+        return;
     }
+}
 
-    if (piece->getType() == ChessPiece::Pawn) {
-        if (QPair<int, int>(newRow, newCol) == enPassantTarget) {
-            // The pawn being captured is behind the en passant target square
-            int capturedPawnRow = oldRow;
-            int capturedPawnCol = newCol;
+// Pieces offered to a promoting pawn, from the promotion square inwards
+static const PieceType promotionChoices[] = {QUEEN, KNIGHT, ROOK, BISHOP};
+
+// Dim the board and stack the choices on the promotion file, starting at
+// the promotion square, as a column the next click picks from
+void Board::showPromotionChooser(int from, int to) {
+    closePromotionChooser();
+    promotionFrom = from;
+    promotionTo = to;
+
+    auto* shade = new QGraphicsRectItem(border, border, 8 * squareSize, 8 * squareSize);
+    shade->setBrush(QColor(0, 0, 0, 90));
+    shade->setPen(Qt::NoPen);
+    shade->setZValue(200);
+    addItem(shade);
+    promotionItems.append(shade);
+
+    Color us = position.sideToMove();
+    int step = (rowOf(to) == 0) ? 1 : -1;
+    for (int i = 0; i < 4; ++i) {
+        int row = rowOf(to) + i * step;
+        auto* square = new QGraphicsRectItem(border + colOf(to) * squareSize, border + row * squareSize,
+                                             squareSize, squareSize);
+        square->setBrush(QColor(236, 240, 241));
+        square->setPen(QPen(QColor(44, 62, 80), 2));
+        square->setZValue(201);
+        addItem(square);
+        promotionItems.append(square);
+
+        ChessPiece* choice = createPieceItem(makePiece(us, promotionChoices[i]), row, colOf(to));
+        choice->updateGraphicsPosition(border, squareSize);
+        choice->setZValue(202);
+        addItem(choice);
+        promotionItems.append(choice);
+    }
+}
 
-            if (board[capturedPawnRow][capturedPawnCol]) {
-                removeItem(board[capturedPawnRow][capturedPawnCol]);
-                delete board[capturedPawnRow][capturedPawnCol];
-                board[capturedPawnRow][capturedPawnCol] = nullptr;
-            }
+void Board::closePromotionChooser() {
+    for (QGraphicsItem* item : promotionItems) {
+        removeItem(item);
+        delete item;
+    }
+    promotionItems.clear();
+    promotionFrom = promotionTo = -1;
+}
+
+// A click on a choice promotes to it; anywhere else takes the pawn back
+void Board::choosePromotion(int row, int col) {
+    int from = promotionFrom;
+    int to = promotionTo;
+    closePromotionChooser();
+
+    int index = (rowOf(to) == 0) ? row : 7 - row;
+    if (col != colOf(to) || index < 0 || index >= 4)
+        return;
+
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (Move m : moves) {
+        if (m.from() == from && m.to() == to && m.promotionType() == promotionChoices[index]) {
+            playMove(m);
+            return;
         }
     }
+}
 
-    // Capture if needed
-    if (board[newRow][newCol]) {
-        removeItem(board[newRow][newCol]);
-        delete board[newRow][newCol];
+bool Board::playExternalMove(Move m) {
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (Move legal : moves) {
+        if (legal == m) {
+            resetSelection();
+            closePromotionChooser();
+            playMove(m);
+            return true;
+        }
     }
+    return false;
+}
 
-    // Standard piece move
-    board[oldRow][oldCol] = nullptr;
-    board[newRow][newCol] = piece;
-    piece->setBoardPosition(newRow, newCol);
+// Put a scene item on a square of the board array and the view
+void Board::placeItem(ChessPiece* piece, int sq) {
+    int row = rowOf(sq);
+    int col = colOf(sq);
+    board[row][col] = piece;
+    piece->setBoardPosition(row, col);
     piece->updateGraphicsPosition(border, squareSize);
+}
 
-    if (!piece->hasMoved())
-        piece->markMoved();  // ✅ important: mark the king (or any piece) as moved
+// Apply a legal move to the position and the scene; nothing is deleted so
+// the move can be taken back.
+void Board::playMove(Move m) {
+    int from = m.from();
+    int to = m.to();
+    Color us = position.sideToMove();
+    ChessPiece* piece = board[rowOf(from)][colOf(from)];
 
-    if (piece->getType() == ChessPiece::Pawn && abs(newRow - oldRow) == 2) {
-        if (piece->getColor() == ChessPiece::White) {
-            enPassantTarget = QPair<int, int>(oldRow - 1, newCol);
-        } else { // Black
-            enPassantTarget = QPair<int, int>(oldRow + 1, newCol);
-        }
-    } else {
-        enPassantTarget = QPair<int, int>(-1, -1);  // Clear en passant
+    PlayedMove record = {m, UndoInfo(), nullptr, nullptr};
+
+    if (m.isCapture()) {
+        int capSq = m.isEnPassant() ? to + (us == WHITE ? -8 : 8) : to;
+        record.captured = board[rowOf(capSq)][colOf(capSq)];
+        board[rowOf(capSq)][colOf(capSq)] = nullptr;
+        removeItem(record.captured);
+    }
+
+    board[rowOf(from)][colOf(from)] = nullptr;
+    placeItem(piece, to);
+
+    // The king has already moved; bring the rook across it
+    if (m.isCastle()) {
+        int rookFrom = (m.flags() == KING_CASTLE) ? to + 1 : to - 2;
+        int rookTo = (m.flags() == KING_CASTLE) ? to - 1 : to + 1;
+        ChessPiece* rook = board[rowOf(rookFrom)][colOf(rookFrom)];
+        board[rowOf(rookFrom)][colOf(rookFrom)] = nullptr;
+        placeItem(rook, rookTo);
     }
 
+    if (m.isPromotion()) {
+        record.promotedPawn = piece;
+        removeItem(piece);
+        ChessPiece* promoted = createPieceItem(makePiece(us, m.promotionType()), rowOf(to), colOf(to));
+        placeItem(promoted, to);
+        addItem(promoted);
+    }
+
+    position.makeMove(m, record.undo);
+    history.append(record);
+    positionKeys.push(position.key());
+
     switchTurn();
     updateCheckHighlight();
 
     if (isCheckmate(currentPlayer)) {
         emit checkmate(currentPlayer);
+    } else {
+        switch (drawReason(position, positionKeys)) {
+        case DRAW_STALEMATE:
+            emit stalemate(currentPlayer);
+            break;
+        case DRAW_REPETITION:
+            emit drawByRepetition();
+            break;
+        case DRAW_FIFTY_MOVES:
+            emit drawByFiftyMoves();
+            break;
+        case DRAW_INSUFFICIENT_MATERIAL:
+            emit drawByInsufficientMaterial();
+            break;
+        case NO_DRAW:
+            break;
+        }
     }
+    emit movePlayed(m);
 }
 
+bool Board::takeBack() {
+    if (history.isEmpty())
+        return false;
+
+    resetSelection();
+    closePromotionChooser();
+    PlayedMove record = history.takeLast();
+    Move m = record.move;
+    int from = m.from();
+    int to = m.to();
+
+    position.unmakeMove(m, record.undo);
+    positionKeys.pop();
+    Color us = position.sideToMove();
+
+    ChessPiece* piece = board[rowOf(to)][colOf(to)];
+    board[rowOf(to)][colOf(to)] = nullptr;
+    if (record.promotedPawn) {
+        removeItem(piece);
+        delete piece;
+        piece = record.promotedPawn;
+        addItem(piece);
+    }
+    placeItem(piece, from);
+
+    if (m.isCastle()) {
+        int rookFrom = (m.flags() == KING_CASTLE) ? to + 1 : to - 2;
+        int rookTo = (m.flags() == KING_CASTLE) ? to - 1 : to + 1;
+        ChessPiece* rook = board[rowOf(rookTo)][colOf(rookTo)];
+        board[rowOf(rookTo)][colOf(rookTo)] = nullptr;
+        placeItem(rook, rookFrom);
+    }
+
+    if (record.captured) {
+        int capSq = m.isEnPassant() ? to + (us == WHITE ? -8 : 8) : to;
+        placeItem(record.captured, capSq);
+        addItem(record.captured);
+    }
+
+    switchTurn();
+    updateCheckHighlight();
+    return true;
+}
+
+// Items parked in the history are not in the scene, so the scene will not free them
+void Board::clearHistory() {
+    for (const PlayedMove& record : history) {
+        delete record.captured;
+        delete record.promotedPawn;
+    }
+    history.clear();
+    positionKeys.reset(position.key());
+}
 
 void Board::highlightMoves(const QVector<QPair<int, int>>& moves) {
     clearHighlights();  // Clear previous highlights
@@ -354,62 +609,32 @@ void Board::clear() {
         }
     }
     resetSelection();
+    closePromotionChooser();
+    clearHistory();
+    position.clear();
+    startPosition.clear();
     currentPlayer = ChessPiece::White;
     emit turnChanged(currentPlayer);
 }
 
 bool Board::isInCheck(ChessPiece::PieceColor color) const {
-    int kingRow = -1, kingCol = -1;
-    bool found = false;
-
-    for (int row = 0; row < 8 && !found; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece* piece = board[row][col];
-            if (piece && piece->getType() == ChessPiece::King && piece->getColor() == color) {
-                kingRow = row;
-                kingCol = col;
-                found = true;
-                break;
-            }
-        }
-    }
+    Color c = toCoreColor(color);
+    int kingSq = position.kingSquare(c);
 
-    if (!found) {
+    if (kingSq == NO_SQUARE) {
         qWarning() << "King not found!";
         return false;
     }
 
-    // Check if king is attacked by opponent
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece* piece = board[row][col];
-            if (piece && piece->getColor() != color) {
-                QVector<QPair<int, int>> moves = piece->getValidMoves(board);
-                for (const auto& move : moves) {
-                    if (move.first == kingRow && move.second == kingCol) {
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-
-    return false;
+    return position.isSquareAttacked(kingSq, ~c);
 }
 void Board::updateCheckHighlight() {
     clearCheckHighlight();
 
     // If current player is in check, highlight their king
     if (isInCheck(currentPlayer)) {
-        for (int row = 0; row < 8; ++row) {
-            for (int col = 0; col < 8; ++col) {
-                ChessPiece* piece = board[row][col];
-                if (piece && piece->getType() == ChessPiece::King && piece->getColor() == currentPlayer) {
-                    highlightCheck(row, col);
-                    return;
-                }
-            }
-        }
+        int kingSq = position.kingSquare(toCoreColor(currentPlayer));
+        highlightCheck(rowOf(kingSq), colOf(kingSq));
     }
 }
 
@@ -456,235 +681,37 @@ void Board::clearCheckHighlight() {
 
 
 
-bool Board::isCheckmate(ChessPiece::PieceColor color) {
-    if (!isInCheck(color)) return false;
-
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece* piece = board[row][col];
-            if (piece && piece->getColor() == color) {
-                QVector<QPair<int, int>> legal = getLegalMoves(piece);
-                if (!legal.isEmpty()) {
-                    return false;
-                }
-            }
-        }
-    }
+bool Board::isCheckmate(ChessPiece::PieceColor color) const {
+    // Only the side to move can be checkmated
+    if (toCoreColor(color) != position.sideToMove() || !isInCheck(color))
+        return false;
 
-    return true;
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    return moves.isEmpty();
 }
 
 
 
-bool Board::isLegalMove(ChessPiece* piece, int toRow, int toCol) {
-    int fromRow = piece->getRow();
-    int fromCol = piece->getCol();
-
-    ChessPiece* captured = board[toRow][toCol];
-    board[toRow][toCol] = piece;
-    board[fromRow][fromCol] = nullptr;
-    piece->setBoardPosition(toRow, toCol);
-
-    bool safe = !isInCheck(piece->getColor());
-
-    // Undo the move
-    board[fromRow][fromCol] = piece;
-    board[toRow][toCol] = captured;
-    piece->setBoardPosition(fromRow, fromCol);
-
-    return safe;
-}
-
+// Destination squares of every legal move for this piece
 QVector<QPair<int, int>> Board::getLegalMoves(ChessPiece* piece) {
     QVector<QPair<int, int>> result;
-    QVector<QPair<int, int>> moves = piece->getValidMoves(board);
-
-    if (piece->getType() == ChessPiece::King) {
-        QVector<QPair<int,int>> castleMoves = getCastlingMoves(piece);
-        moves.append(castleMoves);
-    }
-    if (piece->getType() == ChessPiece::Pawn) {
-        auto enPassant = getEnPassantMove(piece);
-        if (enPassant.has_value() && isLegalMove(piece, enPassant->first, enPassant->second)) {
-            moves.append(*enPassant);
-        }
-    }
-
-    for (const auto& mv : moves) {
-        if (isLegalMove(piece, mv.first, mv.second)) {
-            result.append(mv);
-        }
-    }
-    return result;
-}
 
-QVector<QPair<int, int>> Board::getCastlingMoves(ChessPiece* king){
-    QVector<QPair<int, int>> castlingMoves;
+    MoveList moves;
+    generateLegalMoves(position, moves);
 
-    if(king->hasMoved() || isInCheck(king->getColor())){
-        return castlingMoves;
-    }
-
-    int row = king->getRow();
-    int col = king->getCol();
-
-    if (canCastle(king->getColor(), true)) {
-        // Assume rook is at (row, 7)
-        // Add move for king to move two squares right
-        castlingMoves.append(qMakePair(row, col + 2));
-    }
-
-    // Check queenside castling (left side)
-    if (canCastle(king->getColor(), false)) {
-        // Assume rook is at (row, 0)
-        // Add move for king to move two squares left
-        castlingMoves.append(qMakePair(row, col - 2));
-    }
-
-    return castlingMoves;
-}
-
-bool Board::canCastle(ChessPiece::PieceColor color, bool kingside){
-    int row = (color == ChessPiece::White)? 7 : 0;
-    int kingCol = 4;
-
-    int rookCol = (kingside)? 7 : 0;
-
-    ChessPiece* rook = board[row][rookCol];
-    ChessPiece* king = board[row][kingCol];
-
-    if(!king || !rook){
-        return false;
-    }
-
-    if (king->getColor() != color || rook->getColor() != color)
-        return false;
+    int from = squareFromRowCol(piece->getRow(), piece->getCol());
+    for (Move mv : moves) {
+        if (mv.from() != from)
+            continue;
 
-    // Neither king nor rook must have moved
-    if (king->hasMoved() || rook->hasMoved())
-        return false;
-
-    int step = kingside? 1 : -1;
-    int start = kingCol + step;
-    int end = kingside? rookCol -1 : rookCol + 1;
-
-    for (int c = start; c != end + step; c += step) {
-        if (board[row][c] != nullptr) {
-            return false;  // something blocking the path
-        }
+        QPair<int, int> target(rowOf(mv.to()), colOf(mv.to()));
+        if (!result.contains(target))  // promotions share a destination
+            result.append(target);
     }
-
-    if(isInCheck(color)){
-        return false;
-    }
-
-    for (int c = kingCol; c != kingCol + 2 * step + step; c += step) {
-        ChessPiece::PieceColor oppositeColor = (color == ChessPiece::White) ? ChessPiece::Black : ChessPiece::White;
-        if (isSquareAttacked(row, c, oppositeColor)) {
-            return false;
-        }
-        if (c == kingCol + 2 * step)
-            break;
-    }
-
-    return true;
+    return result;
 }
 
 bool Board::isSquareAttacked(int row, int col, ChessPiece::PieceColor byColor) const {
-    for (int r = 0; r < 8; ++r) {
-        for (int c = 0; c < 8; ++c) {
-            ChessPiece* attacker = board[r][c];
-            if (!attacker || attacker->getColor() != byColor)
-                continue;
-
-            QVector<QPair<int, int>> pseudoMoves = attacker->getValidMoves(board);
-
-            for (const auto& move : pseudoMoves) {
-                if (move.first == row && move.second == col) {
-                    return true;  // square is attacked
-                }
-            }
-        }
-    }
-    return false;
-}
-
-bool Board::tryCastling(ChessPiece* king, int newRow, int newCol) {
-    if (king->getType() != ChessPiece::King)
-        return false;
-
-    int oldCol = king->getCol();
-    int row = king->getRow();
-
-    bool kingside = newCol > oldCol;
-
-    int rookCol = kingside ? 7 : 0;
-    int newRookCol = kingside ? newCol - 1 : newCol + 1;
-
-    ChessPiece* rook = board[row][rookCol];
-
-    if (!rook)
-        return false;
-
-    // Move the king
-    board[row][oldCol] = nullptr;
-    board[row][newCol] = king;
-    king->setBoardPosition(row, newCol);
-    king->updateGraphicsPosition(border, squareSize);
-    king->markMoved();
-
-    // Move the rook
-    board[row][rookCol] = nullptr;
-    board[row][newRookCol] = rook;
-    rook->setBoardPosition(row, newRookCol);
-    rook->updateGraphicsPosition(border, squareSize);
-    rook->markMoved();
-
-    return true;
+    return position.isSquareAttacked(squareFromRowCol(row, col), toCoreColor(byColor));
 }
-
-
-std::optional<QPair<int, int>> Board::getEnPassantMove(ChessPiece* piece) {
-    if (!piece || piece->getType() != ChessPiece::Pawn)
-        return std::nullopt;
-
-    int row = piece->getRow();
-    int col = piece->getCol();
-    int dir = (piece->getColor() == ChessPiece::White) ? -1 : 1;
-
-    // Check left
-    if (col > 0 && enPassantTarget == QPair<int, int>(row + dir, col - 1)) {
-        return QPair<int, int>(row + dir, col - 1);
-    }
-
-    // Check right
-    if (col < 7 && enPassantTarget == QPair<int, int>(row + dir, col + 1)) {
-        return QPair<int, int>(row + dir, col + 1);
-    }
-
-    return std::nullopt;
-}
-
-
-bool Board::isStalemate(ChessPiece::PieceColor playerColor) {
-    QVector<ChessPiece*> pieces = getPieces(playerColor);
-
-    // 2. For each piece, check if it has any legal moves
-    for (ChessPiece* piece : pieces) {
-        QVector<QPair<int, int>> legalMoves = getLegalMoves(piece);
-        if (!legalMoves.isEmpty()) {
-            return false;
-        }
-    }
-
-    if (!isInCheck(playerColor)) {
-        return true;
-    }
-
-    return false;
-}
-
-
-
-
-
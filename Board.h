@@ -5,8 +5,12 @@
 #include <QGraphicsSceneMouseEvent> //Mouse Interactions
 #include <QVector>
 #include <QPair>  //Container for board and moves
+#include <vector>
 
 #include "ChessPiece.h"
+#include "Draw.h"
+#include "Move.h"
+#include "Position.h"
 
 class Board : public QGraphicsScene {
     Q_OBJECT
@@ -23,12 +27,40 @@ public:
     ChessPiece::PieceColor getCurrentPlayer() const;
 
     void setupInitialPosition();// Set up standard chess starting position
+    // Replace the game with the position in fen and rebuild the scene items.
+    // On error the board is left as it was.
+    FenError loadFen(std::string_view fen);
+    QString getFen() const;
+    // The game since the last setup or loadFen, as PGN
+    QString getPgn() const;
     void addPiece(ChessPiece* piece);
     ChessPiece* getPiece(int row, int col) const;
 
+    // Headless rules state mirrored by the scene items
+    const Position& getPosition() const;
+    // Zobrist key of the current position, maintained as moves are played
+    uint64_t getZobristKey() const;
+
+    // Keys of the positions before each played move, oldest first
+    std::vector<uint64_t> getGameKeys() const;
+
+    // Undo the last move played on the board; false when there is none
+    bool takeBack();
+
+    // Play a move chosen off the board, e.g. by the engine; false if it is
+    // not legal in the current position
+    bool playExternalMove(Move m);
+
 signals:
     void turnChanged(ChessPiece::PieceColor current);
     void checkmate(ChessPiece::PieceColor loser);
+    // Draws, checked after every move like checkmate
+    void stalemate(ChessPiece::PieceColor player);
+    void drawByRepetition();
+    void drawByFiftyMoves();
+    void drawByInsufficientMaterial();
+    // Emitted after every move, once the turn and check state are updated
+    void movePlayed(Move m);
 
 //Event Handlers
 protected:
@@ -37,6 +69,8 @@ protected:
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
 
 private:
+    Position position;
+    Position startPosition;
     QVector<QVector<ChessPiece*>> board;
     int border;
     int squareSize;
@@ -52,10 +86,22 @@ private:
 
     //Move Legality Logic
 
-    bool isLegalMove(ChessPiece* piece, int toRow, int toCol);
     QVector<QPair<int, int>> getLegalMoves(ChessPiece* piece);
 
     void movePiece(ChessPiece* piece, int newRow, int newCol);
+
+    // Promotion chooser drawn over the board while a pawn waits to promote
+    int promotionFrom = -1;
+    int promotionTo = -1;
+    QVector<QGraphicsItem*> promotionItems;
+    void showPromotionChooser(int from, int to);
+    void closePromotionChooser();
+    void choosePromotion(int row, int col);
+    bool isChoosingPromotion() const { return !promotionItems.isEmpty(); }
+    void playMove(Move m);
+    void placeItem(ChessPiece* piece, int sq);
+    void clearHistory();
+    void rebuildFromPosition();
     void highlightMoves(const QVector<QPair<int, int>> &moves);
     void clearHighlights();
     QGraphicsItem* pieceAt(int row, int col);
@@ -67,17 +113,23 @@ private:
     void clearCheckHighlight();
     void updateCheckHighlight();
     bool isInCheck(ChessPiece::PieceColor color) const;
-    bool isCheckmate(ChessPiece::PieceColor color);
+    bool isCheckmate(ChessPiece::PieceColor color) const;
 
-    // Castling moves
-    QVector<QPair<int, int>> getCastlingMoves(ChessPiece* king);
-    bool canCastle(ChessPiece::PieceColor color, bool kingside);
     bool isSquareAttacked(int row, int col, ChessPiece::PieceColor byColor) const;
-    bool tryCastling(ChessPiece* king, int newRow, int newCol);
 
-    // Enpassant
-    QPair<int, int> enPassantTarget = QPair<int, int>(-1, -1);
-    std::optional<QPair<int, int>> getEnPassantMove(ChessPiece* piece);
+    // Played moves with the scene items they took off the board. Captured
+    // pieces and promoted pawns are only removed from the scene, so a
+    // takeback puts the same items back.
+    struct PlayedMove {
+        Move move;
+        UndoInfo undo;
+        ChessPiece* captured;
+        ChessPiece* promotedPawn;
+    };
+    QVector<PlayedMove> history;
+    // Keys of the start position and every position played since, for
+    // repetitions
+    RepetitionHistory positionKeys;
 };
 
 #endif
@@ -0,0 +1,58 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+// Opening books in Polyglot .bin format, read through a memory mapping.
+//
+// A book is an array of 16-byte big-endian entries sorted by key: the
+// position's Polyglot key, the move, a weight and a learning field. A probe
+// binary searches the mapped entries, so it touches a handful of pages and
+// never reads the file itself.
+
+#include <cstddef>
+#include <cstdint>
+#include "MappedFile.h"
+#include "Move.h"
+#include "Position.h"
+
+// Key of pos under the Polyglot scheme books are indexed by; unrelated to
+// the engine's own Zobrist key.
+uint64_t polyglotKey(const Position& pos);
+
+struct BookMove {
+    Move move;
+    uint16_t weight;
+};
+
+// More than any position has in a real book
+const int MAX_BOOK_MOVES = 64;
+
+class Book {
+public:
+    Book() : m_entries(0) {}
+
+    Book(const Book&) = delete;
+    Book& operator=(const Book&) = delete;
+
+    // False if the file cannot be mapped or is not a whole number of entries.
+    bool open(const char* path);
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    size_t entryCount() const { return m_entries; }
+
+    // Fill moves with the book's legal moves for pos, highest weight first,
+    // and return how many there are.
+    int probe(const Position& pos, BookMove* moves, int maxMoves = MAX_BOOK_MOVES) const;
+
+    // A book move for pos, or a null move if the book has none. With
+    // bestOnly the highest weighted one, otherwise each move with a chance
+    // in proportion to its weight, drawn with random. Moves of weight zero
+    // are never picked.
+    Move pick(const Position& pos, bool bestOnly, uint64_t random) const;
+
+private:
+    MappedFile m_file;
+    size_t m_entries;
+};
+
+#endif // BOOK_H
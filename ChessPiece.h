@@ -21,8 +21,6 @@ public:
     void setBoardPosition(int row, int col);
     void updateGraphicsPosition(int border, int squareSize);
 
-    virtual QVector<QPair<int, int>> getValidMoves(const QVector<QVector<ChessPiece*>> &board) = 0;
-
     bool hasMoved() const;
     void markMoved();
 
@@ -0,0 +1,87 @@
+#include "Draw.h"
+
+#include <algorithm>
+#include "Bitboard.h"
+#include "MoveGen.h"
+
+namespace {
+
+const Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+} // namespace
+
+const char* drawReasonName(DrawReason reason) {
+    static const char* const names[] = {"none", "stalemate", "threefold repetition", "fifty-move rule",
+                                        "insufficient material"};
+    return names[reason];
+}
+
+bool isInsufficientMaterial(const Position& pos) {
+    Bitboard heavy = 0;
+    for (Color c : {WHITE, BLACK})
+        heavy |= pos.pieces(c, PAWN) | pos.pieces(c, ROOK) | pos.pieces(c, QUEEN);
+    if (heavy)
+        return false;
+
+    Bitboard knights = pos.pieces(WHITE, KNIGHT) | pos.pieces(BLACK, KNIGHT);
+    Bitboard bishops = pos.pieces(WHITE, BISHOP) | pos.pieces(BLACK, BISHOP);
+    if (popCount(knights | bishops) <= 1)
+        return true;
+    return !knights && (!(bishops & DARK_SQUARES) || !(bishops & ~DARK_SQUARES));
+}
+
+bool hasMatingMaterial(const Position& pos, Color c) {
+    return (pos.pieces(c) & ~pos.pieces(c, KING)) && !isInsufficientMaterial(pos);
+}
+
+void RepetitionHistory::reset(uint64_t key) {
+    m_keys[0] = key;
+    m_count = 1;
+    m_pushed = 1;
+}
+
+void RepetitionHistory::push(uint64_t key) {
+    m_keys[m_count % RING_SIZE] = key;
+    ++m_count;
+    m_pushed = std::max(m_pushed, m_count);
+}
+
+void RepetitionHistory::pop() {
+    if (m_count > 1)
+        --m_count;
+}
+
+int RepetitionHistory::occurrences(int halfmoveClock) const {
+    if (m_count == 0)
+        return 0;
+    // Slots of positions taken back still hold them and have overwritten
+    // older ones, which are out of reach until the game gets there again
+    int reach = std::min({halfmoveClock, static_cast<int>(m_count) - 1,
+                          RING_SIZE - 1 - static_cast<int>(m_pushed - m_count)});
+    uint32_t last = m_count - 1;
+    uint64_t key = m_keys[last % RING_SIZE];
+    int count = 1;
+    // The side to move must match, so only every other position can repeat
+    for (int back = 4; back <= reach; back += 2)
+        if (m_keys[(last - back) % RING_SIZE] == key)
+            ++count;
+    return count;
+}
+
+DrawReason drawByRule(const Position& pos, const RepetitionHistory& history) {
+    if (isInsufficientMaterial(pos))
+        return DRAW_INSUFFICIENT_MATERIAL;
+    if (pos.halfmoveClock() >= 100)
+        return DRAW_FIFTY_MOVES;
+    if (pos.halfmoveClock() >= 4 && history.occurrences(pos.halfmoveClock()) >= 3)
+        return DRAW_REPETITION;
+    return NO_DRAW;
+}
+
+DrawReason drawReason(const Position& pos, const RepetitionHistory& history) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (moves.isEmpty())
+        return pos.inCheck() ? NO_DRAW : DRAW_STALEMATE;
+    return drawByRule(pos, history);
+}
@@ -0,0 +1,70 @@
+#ifndef DRAW_H
+#define DRAW_H
+
+// Draws by rule: stalemate, threefold repetition, the fifty-move rule and
+// insufficient material.
+//
+// Repetitions are found in a ring of the game's Zobrist keys. Only positions
+// since the last capture or pawn move can repeat, and those are the last
+// halfmoveClock entries, so a test compares at most half that many keys
+// and never replays the game.
+
+#include <cstdint>
+#include "Position.h"
+
+enum DrawReason : uint8_t {
+    NO_DRAW,
+    DRAW_STALEMATE,
+    DRAW_REPETITION,
+    DRAW_FIFTY_MOVES,
+    DRAW_INSUFFICIENT_MATERIAL
+};
+
+const char* drawReasonName(DrawReason reason);
+
+// Neither side can ever mate: bare kings, a single minor piece, or bishops
+// only, all on squares of one colour.
+bool isInsufficientMaterial(const Position& pos);
+
+// Whether c could still mate, with the other side's help if need be: not
+// with a lone king, and neither side can when isInsufficientMaterial holds.
+bool hasMatingMaterial(const Position& pos, Color c);
+
+// Keys of the positions of one game, oldest first, with only the newest
+// RING_SIZE kept. That covers any stretch the fifty-move rule leaves open.
+class RepetitionHistory {
+public:
+    static const int RING_SIZE = 256;
+
+    RepetitionHistory() : m_count(0), m_pushed(0) {}
+
+    // Start a game at the position with key
+    void reset(uint64_t key);
+    // Record the position a move reached, or forget it when the move is
+    // taken back. Taking back many moves of a long game narrows the window
+    // occurrences() can see until the game is played on again.
+    void push(uint64_t key);
+    void pop();
+
+    int size() const { return static_cast<int>(m_count); }
+
+    // How often the newest position has occurred, itself included, when the
+    // last halfmoveClock moves were reversible
+    int occurrences(int halfmoveClock) const;
+
+private:
+    uint64_t m_keys[RING_SIZE];
+    uint32_t m_count;
+    uint32_t m_pushed;      // highest m_count since the reset
+};
+
+// The draws that need no move generation: insufficient material,
+// threefold repetition and the fifty-move rule. Only right when the side to
+// move has a legal move, as everywhere but the end of a recorded game; a
+// mate on the hundredth reversible ply still wins.
+DrawReason drawByRule(const Position& pos, const RepetitionHistory& history);
+
+// Every draw, stalemate included, for history's newest position pos.
+DrawReason drawReason(const Position& pos, const RepetitionHistory& history);
+
+#endif // DRAW_H
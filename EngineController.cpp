@@ -0,0 +1,108 @@
+#include "EngineController.h"
+
+EngineWorker::EngineWorker(std::atomic<int>& latestRequest)
+    : latestRequest(latestRequest), table(32), search(table) {}
+
+void EngineWorker::think(int requestId, const Position& root, const SearchLimits& limits,
+                         const std::vector<uint64_t>& history, uint64_t stopsSeen) {
+    // Cancelled while it waited behind the previous search
+    if (requestId != latestRequest.load())
+        return;
+
+    search.setInfoCallback([this, requestId](const SearchInfo& si) {
+        emit info(requestId, si.depth, si.score, si.nodes);
+    });
+
+    // A cancel from here on stops the run, even one before it starts
+    SearchResult result = search.run(root, limits, history, stopsSeen);
+    emit bestMove(requestId, result.bestMove.raw());
+}
+
+void EngineWorker::newGame() {
+    table.clear();
+    search.clear();
+}
+
+void EngineWorker::setBookFile(const QString& path) {
+    search.setBook(nullptr);
+    book.close();
+    if (!path.isEmpty() && book.open(path.toLocal8Bit().constData()))
+        search.setBook(&book);
+}
+
+void EngineWorker::setTablebasePath(const QString& path) {
+    search.setTablebases(nullptr);
+    tablebases.clear();
+    if (!path.isEmpty() && tablebases.init(path.toLocal8Bit().constData()) > 0)
+        search.setTablebases(&tablebases);
+}
+
+EngineController::EngineController(QObject* parent)
+    : QObject(parent), latestRequest(0) {
+    worker = new EngineWorker(latestRequest);
+    worker->moveToThread(&thread);
+    connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+
+    // Cross-thread signals are queued, so these slots run on the GUI thread
+    connect(worker, &EngineWorker::info, this, &EngineController::onInfo);
+    connect(worker, &EngineWorker::bestMove, this, &EngineController::onBestMove);
+
+    thread.setObjectName("engine");
+    thread.start();
+}
+
+EngineController::~EngineController() {
+    cancel();
+    thread.quit();
+    thread.wait();
+}
+
+void EngineController::think(const Position& root, int moveTimeMs, const std::vector<uint64_t>& history) {
+    cancel();
+
+    SearchLimits limits;
+    limits.moveTimeMs = moveTimeMs;
+    int requestId = latestRequest.load();
+    uint64_t stopsSeen = worker->stopRequests();
+    thinking = true;
+
+    // The worker gets its own copies; the board keeps changing meanwhile
+    EngineWorker* w = worker;
+    QMetaObject::invokeMethod(worker, [w, requestId, root, limits, history, stopsSeen] {
+        w->think(requestId, root, limits, history, stopsSeen);
+    }, Qt::QueuedConnection);
+}
+
+void EngineController::cancel() {
+    ++latestRequest;
+    worker->stop();
+    thinking = false;
+}
+
+void EngineController::newGame() {
+    cancel();
+    EngineWorker* w = worker;
+    QMetaObject::invokeMethod(worker, [w] { w->newGame(); }, Qt::QueuedConnection);
+}
+
+void EngineController::setBookFile(const QString& path) {
+    EngineWorker* w = worker;
+    QMetaObject::invokeMethod(worker, [w, path] { w->setBookFile(path); }, Qt::QueuedConnection);
+}
+
+void EngineController::setTablebasePath(const QString& path) {
+    EngineWorker* w = worker;
+    QMetaObject::invokeMethod(worker, [w, path] { w->setTablebasePath(path); }, Qt::QueuedConnection);
+}
+
+void EngineController::onInfo(int requestId, int depth, int score, quint64 nodes) {
+    if (requestId == latestRequest.load())
+        emit searchInfo(depth, score, nodes);
+}
+
+void EngineController::onBestMove(int requestId, quint16 move) {
+    if (requestId != latestRequest.load())
+        return;
+    thinking = false;
+    emit moveFound(Move::fromRaw(move));
+}
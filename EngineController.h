@@ -0,0 +1,98 @@
+#ifndef ENGINECONTROLLER_H
+#define ENGINECONTROLLER_H
+
+// Runs the engine on its own QThread so the GUI thread never waits on a search.
+//
+// Requests go to the worker thread as queued calls and results come back as
+// queued signals. Every request gets an id; cancel() stops the running search
+// and bumps the id so a result that was already on its way is dropped.
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+#include "Book.h"
+#include "Move.h"
+#include "Position.h"
+#include "Search.h"
+#include "Tablebases.h"
+#include "TranspositionTable.h"
+
+// Lives on the engine thread; only EngineController talks to it.
+class EngineWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit EngineWorker(std::atomic<int>& latestRequest);
+
+    // Called from the GUI thread: Search::stop is thread-safe.
+    void stop() { search.stop(); }
+    uint64_t stopRequests() const { return search.stopRequests(); }
+
+    // Run on the engine thread through queued calls. stopsSeen is
+    // stopRequests() when the request was made, so a cancel that comes
+    // before the search starts still stops it.
+    void think(int requestId, const Position& root, const SearchLimits& limits,
+               const std::vector<uint64_t>& history, uint64_t stopsSeen);
+    void newGame();
+    void setBookFile(const QString& path);
+    void setTablebasePath(const QString& path);
+
+signals:
+    void info(int requestId, int depth, int score, quint64 nodes);
+    void bestMove(int requestId, quint16 move);
+
+private:
+    std::atomic<int>& latestRequest;
+    TranspositionTable table;
+    Book book;
+    Tablebases tablebases;
+    Search search;
+};
+
+class EngineController : public QObject {
+    Q_OBJECT
+
+public:
+    explicit EngineController(QObject* parent = nullptr);
+    ~EngineController();
+
+    // Search root in the background; history holds the keys of the positions
+    // played before it. Any search still running is cancelled first.
+    void think(const Position& root, int moveTimeMs, const std::vector<uint64_t>& history);
+
+    // Stop the running search and drop its result. Safe to call when idle.
+    void cancel();
+
+    // Clear the table and move-ordering statistics before the next search.
+    void newGame();
+
+    // Play opening moves from a Polyglot book; an empty path turns it off.
+    void setBookFile(const QString& path);
+
+    // Probe Syzygy tablebases in these directories (separated as in PATH);
+    // an empty path turns probing off.
+    void setTablebasePath(const QString& path);
+
+    bool isThinking() const { return thinking; }
+
+signals:
+    // Progress of the current search after each completed iteration
+    void searchInfo(int depth, int score, quint64 nodes);
+    void moveFound(Move move);
+
+private slots:
+    void onInfo(int requestId, int depth, int score, quint64 nodes);
+    void onBestMove(int requestId, quint16 move);
+
+private:
+    QThread thread;
+    EngineWorker* worker;
+    // Written by the GUI thread, read by the worker to skip stale requests
+    std::atomic<int> latestRequest;
+    bool thinking = false;
+};
+
+#endif // ENGINECONTROLLER_H
@@ -0,0 +1,198 @@
+#include "Evaluate.h"
+#include "Attacks.h"
+#include "PawnTable.h"
+
+const int pieceValue[PIECE_TYPE_NB] = {100, 320, 330, 500, 900, 0};
+
+namespace {
+
+// Bonus for the side to move
+const int TEMPO = 10;
+
+const Score DOUBLED_PAWN = makeScore(-10, -20);
+const Score ISOLATED_PAWN = makeScore(-10, -15);
+const Score BACKWARD_PAWN = makeScore(-8, -10);
+
+// By rank from the pawn owner's side
+const Score passedPawnBonus[8] = {
+    makeScore(0, 0), makeScore(5, 10), makeScore(10, 20), makeScore(15, 35),
+    makeScore(25, 60), makeScore(40, 100), makeScore(60, 150), makeScore(0, 0)
+};
+
+// Extra for a passed pawn whose path is clear of pieces, by rank
+const Score freePassedPawnBonus[8] = {
+    makeScore(0, 0), makeScore(0, 0), makeScore(0, 5), makeScore(0, 10),
+    makeScore(0, 20), makeScore(0, 35), makeScore(0, 60), makeScore(0, 0)
+};
+
+// Per safe square attacked, counted from a typical number of squares
+const Score mobilityWeight[PIECE_TYPE_NB] = {
+    0, makeScore(4, 4), makeScore(5, 5), makeScore(2, 4), makeScore(1, 2), 0
+};
+const int mobilityBase[PIECE_TYPE_NB] = {0, 4, 7, 7, 14, 0};
+
+// Weight of each attack on a square next to the enemy king
+const int kingAttackWeight[PIECE_TYPE_NB] = {0, 2, 2, 3, 5, 0};
+const int KING_DANGER_MAX = 500;
+
+// Own pawns one and two ranks in front of the king
+const Score PAWN_SHIELD_NEAR = makeScore(12, 0);
+const Score PAWN_SHIELD_FAR = makeScore(6, 0);
+
+Bitboard adjacentFiles[8];
+// Squares in front of a pawn on its file
+Bitboard forwardFile[COLOR_NB][64];
+// Squares an enemy pawn must stand on to stop a pawn from being passed
+Bitboard passedPawnMask[COLOR_NB][64];
+
+void initEvalMasks() {
+    for (int file = 0; file < 8; ++file)
+        adjacentFiles[file] = (file > 0 ? fileBB(file - 1) : 0) | (file < 7 ? fileBB(file + 1) : 0);
+
+    for (int sq = 0; sq < 64; ++sq) {
+        Bitboard files = fileBB(fileOf(sq)) | adjacentFiles[fileOf(sq)];
+        Bitboard above = 0;
+        Bitboard below = 0;
+        for (int rank = rankOf(sq) + 1; rank < 8; ++rank)
+            above |= rankBB(rank);
+        for (int rank = 0; rank < rankOf(sq); ++rank)
+            below |= rankBB(rank);
+
+        forwardFile[WHITE][sq] = above & fileBB(fileOf(sq));
+        forwardFile[BLACK][sq] = below & fileBB(fileOf(sq));
+        passedPawnMask[WHITE][sq] = above & files;
+        passedPawnMask[BLACK][sq] = below & files;
+    }
+}
+
+struct EvalInit {
+    EvalInit() { initEvalMasks(); }
+} evalInit;
+
+Bitboard pawnAttackSpan(Color c, Bitboard pawns) {
+    return c == WHITE ? ((pawns & ~FILE_A_BB) << 7) | ((pawns & ~FILE_H_BB) << 9)
+                      : ((pawns & ~FILE_A_BB) >> 9) | ((pawns & ~FILE_H_BB) >> 7);
+}
+
+// Terms that depend on the pawns alone, so they can be cached by pawn key
+Score evaluatePawns(const Position& pos, Color us, Bitboard& passed) {
+    Color them = ~us;
+    Bitboard ours = pos.pieces(us, PAWN);
+    Bitboard theirs = pos.pieces(them, PAWN);
+    int forward = us == WHITE ? 8 : -8;
+    Score score = 0;
+    passed = 0;
+
+    Bitboard b = ours;
+    while (b) {
+        int sq = popLsb(b);
+        int stop = sq + forward;
+
+        if (!(ours & adjacentFiles[fileOf(sq)]))
+            score += ISOLATED_PAWN;
+        // No pawn beside or behind can support it, and an enemy pawn guards its next square
+        else if (!(ours & adjacentFiles[fileOf(sq)] & passedPawnMask[them][stop])
+                 && (pawnAttacks(us, stop) & theirs))
+            score += BACKWARD_PAWN;
+
+        // Only the front pawn of a doubled pair can be passed
+        if (ours & forwardFile[us][sq]) {
+            score += DOUBLED_PAWN;
+        } else if (!(theirs & passedPawnMask[us][sq])) {
+            score += passedPawnBonus[us == WHITE ? rankOf(sq) : 7 - rankOf(sq)];
+            passed |= squareBB(sq);
+        }
+    }
+    return score;
+}
+
+void fillPawnEntry(const Position& pos, PawnEntry& entry) {
+    entry.key = pos.pawnKey();
+    entry.score = evaluatePawns(pos, WHITE, entry.passed[WHITE]) - evaluatePawns(pos, BLACK, entry.passed[BLACK]);
+}
+
+// Passed pawns with nothing in their way, which the pawn cache cannot know
+Score evaluatePassedPaths(const Position& pos, Color us, Bitboard passed) {
+    Bitboard occupied = pos.occupied();
+    Score score = 0;
+    while (passed) {
+        int sq = popLsb(passed);
+        if (!(forwardFile[us][sq] & occupied))
+            score += freePassedPawnBonus[us == WHITE ? rankOf(sq) : 7 - rankOf(sq)];
+    }
+    return score;
+}
+
+// Mobility of our pieces plus the pressure they put on the enemy king
+Score evaluatePieces(const Position& pos, Color us) {
+    Color them = ~us;
+    Bitboard occupied = pos.occupied();
+    Bitboard mobilityArea = ~pos.pieces(us) & ~pawnAttackSpan(them, pos.pieces(them, PAWN));
+    int theirKing = pos.kingSquare(them);
+    Bitboard kingZone = kingAttacks(theirKing) | squareBB(theirKing);
+
+    Score score = 0;
+    int attackers = 0;
+    int attackUnits = 0;
+    for (int pt = KNIGHT; pt <= QUEEN; ++pt) {
+        Bitboard pieces = pos.pieces(us, static_cast<PieceType>(pt));
+        while (pieces) {
+            Bitboard attacks = attacksFrom(static_cast<PieceType>(pt), popLsb(pieces), occupied);
+            score += mobilityWeight[pt] * (popCount(attacks & mobilityArea) - mobilityBase[pt]);
+            if (attacks & kingZone) {
+                ++attackers;
+                attackUnits += kingAttackWeight[pt] * popCount(attacks & kingZone);
+            }
+        }
+    }
+
+    // A lone attacker is rarely dangerous; danger grows faster than the attack count
+    if (attackers >= 2) {
+        int danger = attackUnits * attackUnits / 4;
+        score += makeScore(danger < KING_DANGER_MAX ? danger : KING_DANGER_MAX, 0);
+    }
+    return score;
+}
+
+Score evaluateKingShelter(const Position& pos, Color us) {
+    int kingSq = pos.kingSquare(us);
+    int rank = rankOf(kingSq);
+    int forward = us == WHITE ? 1 : -1;
+    Bitboard files = fileBB(fileOf(kingSq)) | adjacentFiles[fileOf(kingSq)];
+    Bitboard pawns = pos.pieces(us, PAWN) & files;
+
+    Score score = 0;
+    if (rank + forward >= 0 && rank + forward < 8)
+        score += PAWN_SHIELD_NEAR * popCount(pawns & rankBB(rank + forward));
+    if (rank + 2 * forward >= 0 && rank + 2 * forward < 8)
+        score += PAWN_SHIELD_FAR * popCount(pawns & rankBB(rank + 2 * forward));
+    return score;
+}
+
+int evaluateWith(const Position& pos, const PawnEntry& pawns) {
+    Score score = pos.psqScore() + pawns.score
+                + evaluatePassedPaths(pos, WHITE, pawns.passed[WHITE])
+                - evaluatePassedPaths(pos, BLACK, pawns.passed[BLACK])
+                + evaluatePieces(pos, WHITE) - evaluatePieces(pos, BLACK)
+                + evaluateKingShelter(pos, WHITE) - evaluateKingShelter(pos, BLACK);
+
+    int phase = pos.gamePhase();
+    int value = (mgValue(score) * phase + egValue(score) * (PHASE_MAX - phase)) / PHASE_MAX;
+    return (pos.sideToMove() == WHITE ? value : -value) + TEMPO;
+}
+
+} // namespace
+
+int evaluate(const Position& pos) {
+    PawnEntry pawns;
+    fillPawnEntry(pos, pawns);
+    return evaluateWith(pos, pawns);
+}
+
+int evaluate(const Position& pos, PawnTable& pawnTable) {
+    bool found;
+    PawnEntry* pawns = pawnTable.probe(pos.pawnKey(), found);
+    if (!found)
+        fillPawnEntry(pos, *pawns);
+    return evaluateWith(pos, *pawns);
+}
@@ -0,0 +1,23 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+// Static evaluation in centipawns, from the point of view of the side to move.
+//
+// Material and piece-square tables come incrementally from the position;
+// pawn structure, mobility and king safety are computed from bitboards. The
+// middlegame and endgame halves are blended by the game phase.
+
+#include "Position.h"
+
+class PawnTable;
+
+// Material value of each piece type; the king is never traded so it has none.
+// Used for move ordering, the evaluation has its own tapered values.
+extern const int pieceValue[PIECE_TYPE_NB];
+
+int evaluate(const Position& pos);
+
+// Same score, with pawn-structure terms looked up in or added to pawns.
+int evaluate(const Position& pos, PawnTable& pawns);
+
+#endif // EVALUATE_H
@@ -0,0 +1,438 @@
+#include "GameFile.h"
+#include "Attacks.h"
+#include "MoveGen.h"
+
+#include <cstring>
+
+namespace {
+
+const char MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'G', 'D', 'B'};
+const uint32_t VERSION = 1;
+const size_t HEADER_SIZE = 64;
+const size_t PACKED_SIZE = sizeof(PackedPosition);
+
+// Game flags
+const uint8_t CUSTOM_START = 1;
+
+void putU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void putU64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i)
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint16_t getU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16)
+         | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t getU64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+const Position& standardStart() {
+    static const Position start = [] {
+        Position pos;
+        pos.setStartPosition();
+        return pos;
+    }();
+    return start;
+}
+
+bool isStandardStart(const Position& pos) {
+    return pos.key() == standardStart().key() && pos.halfmoveClock() == 0 && pos.fullmoveNumber() == 1;
+}
+
+// Squares the piece on from may move to by its movement rules alone. This
+// is a superset of its legal targets that reader and writer both derive, so
+// a move is stored as an index into it and decoded without generating
+// legal moves.
+Bitboard moveTargets(const Position& pos, int from) {
+    Color us = pos.sideToMove();
+    PieceType pt = typeOf(pos.pieceOn(from));
+    if (pt == PAWN) {
+        Bitboard enemies = pos.pieces(~us);
+        if (pos.epSquare() != NO_SQUARE)
+            enemies |= squareBB(pos.epSquare());
+        Bitboard targets = pawnAttacks(us, from) & enemies;
+        int forward = us == WHITE ? 8 : -8;
+        if (pos.isEmpty(from + forward)) {
+            targets |= squareBB(from + forward);
+            if (rankOf(from) == (us == WHITE ? 1 : 6) && pos.isEmpty(from + 2 * forward))
+                targets |= squareBB(from + 2 * forward);
+        }
+        return targets;
+    }
+
+    Bitboard targets = attacksFrom(pt, from, pos.occupied()) & ~pos.pieces(us);
+    if (pt == KING && from == (us == WHITE ? 4 : 60)) {
+        int rights = pos.castlingRights();
+        if ((rights & (us == WHITE ? WHITE_OO : BLACK_OO)) && pos.isEmpty(from + 1) && pos.isEmpty(from + 2))
+            targets |= squareBB(from + 2);
+        if ((rights & (us == WHITE ? WHITE_OOO : BLACK_OOO)) && pos.isEmpty(from - 1) && pos.isEmpty(from - 2)
+            && pos.isEmpty(from - 3))
+            targets |= squareBB(from - 2);
+    }
+    return targets;
+}
+
+// A pawn about to promote has one move per target and promotion piece
+int movesPerTarget(const Position& pos, int from) {
+    if (typeOf(pos.pieceOn(from)) != PAWN)
+        return 1;
+    return rankOf(from) == (pos.sideToMove() == WHITE ? 6 : 1) ? 4 : 1;
+}
+
+// Bytes a ply takes: the moving piece's index among the side to move's
+// pieces in the high nibble, the move's index among that piece's moves in
+// the low one. A low nibble of LONG_MOVE means a second byte holds the rest
+// of the move index, which only far-reaching slider moves need.
+const int LONG_MOVE = 15;
+
+// Append the code for m, which must be legal in pos; false if the side to
+// move has more pieces than a nibble can count
+bool appendMoveCode(const Position& pos, Move m, std::vector<uint8_t>& out) {
+    Bitboard ours = pos.pieces(pos.sideToMove());
+    int piece = popCount(ours & (squareBB(m.from()) - 1));
+    if (piece > 15)
+        return false;
+    Bitboard targets = moveTargets(pos, m.from());
+    int move = popCount(targets & (squareBB(m.to()) - 1)) * movesPerTarget(pos, m.from());
+    if (m.isPromotion())
+        move += m.promotionType() - KNIGHT;
+
+    out.push_back(static_cast<uint8_t>((piece << 4) | (move < LONG_MOVE ? move : LONG_MOVE)));
+    if (move >= LONG_MOVE)
+        out.push_back(static_cast<uint8_t>(move - LONG_MOVE));
+    return true;
+}
+
+// The move a code names, or a null move if the code is out of range or the
+// move it names is not legal
+Move decodeMove(const Position& pos, int piece, int move) {
+    Bitboard ours = pos.pieces(pos.sideToMove());
+    for (; piece > 0 && ours; --piece)
+        ours &= ours - 1;
+    if (!ours)
+        return Move();
+    int from = lsb(ours);
+
+    Bitboard targets = moveTargets(pos, from);
+    int perTarget = movesPerTarget(pos, from);
+    for (int skip = move / perTarget; skip > 0 && targets; --skip)
+        targets &= targets - 1;
+    if (!targets)
+        return Move();
+    int to = lsb(targets);
+    PieceType promotion = perTarget > 1 ? static_cast<PieceType>(KNIGHT + move % perTarget) : NO_PIECE_TYPE;
+
+    Move m = makeMoveTo(pos, from, to, promotion);
+    if (m.isCastle()) {
+        // The king may not castle out of, through or into check
+        Color them = ~pos.sideToMove();
+        int step = to > from ? 1 : -1;
+        bool safe = !pos.isSquareAttacked(from, them) && !pos.isSquareAttacked(from + step, them)
+                 && !pos.isSquareAttacked(to, them);
+        return safe ? m : Move();
+    }
+    return leavesKingSafe(pos, m) ? m : Move();
+}
+
+} // namespace
+
+bool packPosition(const Position& pos, PackedPosition& packed) {
+    std::memset(packed.bytes, 0, sizeof(packed.bytes));
+    Bitboard occupied = pos.occupied();
+    if (popCount(occupied) > 32)
+        return false;
+
+    putU64(packed.bytes, occupied);
+    int n = 0;
+    while (occupied) {
+        int sq = popLsb(occupied);
+        packed.bytes[8 + n / 2] |= static_cast<uint8_t>(pos.pieceOn(sq) << (4 * (n & 1)));
+        ++n;
+    }
+    packed.bytes[24] = static_cast<uint8_t>(pos.sideToMove() | (pos.castlingRights() << 1));
+    packed.bytes[25] = static_cast<uint8_t>(pos.epSquare());
+    putU16(packed.bytes + 26, static_cast<uint16_t>(pos.halfmoveClock()));
+    putU16(packed.bytes + 28, static_cast<uint16_t>(pos.fullmoveNumber()));
+    return true;
+}
+
+bool unpackPosition(const PackedPosition& packed, Position& pos) {
+    pos.clear();
+    Bitboard occupied = getU64(packed.bytes);
+    if (popCount(occupied) > 32)
+        return false;
+
+    int n = 0;
+    while (occupied) {
+        int sq = popLsb(occupied);
+        Piece pc = static_cast<Piece>((packed.bytes[8 + n / 2] >> (4 * (n & 1))) & 15);
+        if (pc >= NO_PIECE) {
+            pos.clear();
+            return false;
+        }
+        pos.putPiece(pc, sq);
+        ++n;
+    }
+
+    // The same rules a FEN has to pass, so that replaying from the position is safe
+    Bitboard pawns = pos.pieces(WHITE, PAWN) | pos.pieces(BLACK, PAWN);
+    bool valid = popCount(pos.pieces(WHITE, KING)) == 1 && popCount(pos.pieces(BLACK, KING)) == 1
+              && !(pawns & (rankBB(0) | rankBB(7))) && pos.hasReachableMaterial();
+
+    uint8_t state = packed.bytes[24];
+    Color us = static_cast<Color>(state & 1);
+    pos.setSideToMove(us);
+    valid = valid && !pos.isSquareAttacked(pos.kingSquare(~us), us);
+
+    int rights = (state >> 1) & ALL_CASTLING;
+    const int kingSquares[4] = {4, 4, 60, 60};
+    const int rookSquares[4] = {7, 0, 63, 56};
+    for (int i = 0; i < 4; ++i) {
+        Color c = i < 2 ? WHITE : BLACK;
+        if ((rights & (1 << i)) && (pos.pieceOn(kingSquares[i]) != makePiece(c, KING)
+                                    || pos.pieceOn(rookSquares[i]) != makePiece(c, ROOK)))
+            valid = false;
+    }
+    pos.setCastlingRights(rights);
+
+    int ep = packed.bytes[25];
+    if (ep != NO_SQUARE) {
+        int pawnSq = ep + (us == WHITE ? -8 : 8);
+        valid = valid && ep < NO_SQUARE && rankOf(ep) == (us == WHITE ? 5 : 2) && pos.isEmpty(ep)
+             && pos.pieceOn(pawnSq) == makePiece(~us, PAWN);
+        if (valid)
+            pos.setEpSquare(ep);
+    }
+    pos.setHalfmoveClock(getU16(packed.bytes + 26));
+    pos.setFullmoveNumber(getU16(packed.bytes + 28));
+
+    if (!valid)
+        pos.clear();
+    return valid;
+}
+
+GameResult parseResult(std::string_view result) {
+    if (result == "1-0")
+        return WHITE_WINS;
+    if (result == "0-1")
+        return BLACK_WINS;
+    if (result == "1/2-1/2")
+        return DRAW;
+    return UNKNOWN_RESULT;
+}
+
+const char* resultText(GameResult result) {
+    static const char* const texts[] = {"1-0", "0-1", "1/2-1/2", "*"};
+    return texts[result];
+}
+
+GameFileWriter::GameFileWriter()
+    : m_file(nullptr), m_positions(nullptr), m_offset(0), m_positionCount(0), m_ok(false) {}
+
+GameFileWriter::~GameFileWriter() {
+    if (m_file)
+        close();
+}
+
+bool GameFileWriter::open(const char* path) {
+    if (m_file)
+        close();
+    m_file = std::fopen(path, "wb");
+    if (!m_file)
+        return false;
+
+    // The header is written for real once the counts are known
+    uint8_t header[HEADER_SIZE] = {};
+    m_ok = std::fwrite(header, 1, HEADER_SIZE, m_file) == HEADER_SIZE;
+    m_offset = HEADER_SIZE;
+    m_gameOffsets.clear();
+    m_positionCount = 0;
+    return m_ok;
+}
+
+bool GameFileWriter::addGame(const Position& start, const std::vector<Move>& moves, GameResult result) {
+    if (!m_file || moves.size() > 0xFFFF)
+        return false;
+
+    bool custom = !isStandardStart(start);
+    m_record.assign(4, 0);
+    m_record[0] = result;
+    m_record[1] = custom ? CUSTOM_START : 0;
+    putU16(m_record.data() + 2, static_cast<uint16_t>(moves.size()));
+    if (custom) {
+        PackedPosition packed;
+        if (!packPosition(start, packed))
+            return false;
+        m_record.insert(m_record.end(), packed.bytes, packed.bytes + PACKED_SIZE);
+    }
+
+    Position pos = start;
+    for (Move m : moves) {
+        MoveList legal;
+        generateLegalMoves(pos, legal);
+        if (!legal.contains(m) || !appendMoveCode(pos, m, m_record))
+            return false;
+        pos.makeMove(m);
+    }
+
+    m_ok = std::fwrite(m_record.data(), 1, m_record.size(), m_file) == m_record.size() && m_ok;
+    m_gameOffsets.push_back(m_offset);
+    m_offset += m_record.size();
+    return m_ok;
+}
+
+bool GameFileWriter::addPosition(const Position& pos) {
+    if (!m_file)
+        return false;
+    if (!m_positions)
+        m_positions = std::tmpfile();
+    PackedPosition packed;
+    if (!m_positions || !packPosition(pos, packed))
+        return false;
+    m_ok = std::fwrite(packed.bytes, 1, PACKED_SIZE, m_positions) == PACKED_SIZE && m_ok;
+    ++m_positionCount;
+    return m_ok;
+}
+
+bool GameFileWriter::close() {
+    if (!m_file)
+        return false;
+
+    uint64_t indexOffset = m_offset;
+    uint8_t entry[8];
+    for (uint64_t offset : m_gameOffsets) {
+        putU64(entry, offset);
+        m_ok = std::fwrite(entry, 1, 8, m_file) == 8 && m_ok;
+    }
+    uint64_t positionsOffset = indexOffset + 8 * m_gameOffsets.size();
+
+    if (m_positions) {
+        std::rewind(m_positions);
+        char buffer[1 << 16];
+        size_t got;
+        while ((got = std::fread(buffer, 1, sizeof(buffer), m_positions)) > 0)
+            m_ok = std::fwrite(buffer, 1, got, m_file) == got && m_ok;
+        m_ok = !std::ferror(m_positions) && m_ok;
+        std::fclose(m_positions);
+        m_positions = nullptr;
+    }
+
+    uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    header[8] = static_cast<uint8_t>(VERSION);
+    putU64(header + 16, m_gameOffsets.size());
+    putU64(header + 24, indexOffset);
+    putU64(header + 32, m_positionCount);
+    putU64(header + 40, positionsOffset);
+    m_ok = std::fseek(m_file, 0, SEEK_SET) == 0 && m_ok;
+    m_ok = std::fwrite(header, 1, HEADER_SIZE, m_file) == HEADER_SIZE && m_ok;
+    m_ok = std::fclose(m_file) == 0 && m_ok;
+    m_file = nullptr;
+    return m_ok;
+}
+
+GameFile::GameFile()
+    : m_data(nullptr), m_size(0), m_gameCount(0), m_positionCount(0), m_indexOffset(0), m_positionsOffset(0) {}
+
+bool GameFile::open(const char* path) {
+    close();
+    if (!m_file.open(path) || m_file.size() < HEADER_SIZE) {
+        close();
+        return false;
+    }
+    m_data = m_file.data();
+    m_size = m_file.size();
+
+    const uint8_t* header = m_data;
+    m_gameCount = getU64(header + 16);
+    m_indexOffset = getU64(header + 24);
+    m_positionCount = getU64(header + 32);
+    m_positionsOffset = getU64(header + 40);
+    bool valid = std::memcmp(header, MAGIC, sizeof(MAGIC)) == 0 && getU32(header + 8) == VERSION
+              && m_indexOffset >= HEADER_SIZE && m_indexOffset <= m_size && m_gameCount <= (m_size - m_indexOffset) / 8
+              && m_positionsOffset <= m_size && m_positionCount <= (m_size - m_positionsOffset) / PACKED_SIZE;
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void GameFile::close() {
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_gameCount = 0;
+    m_positionCount = 0;
+}
+
+bool GameFile::readGame(uint64_t i, GameRecord& game) const {
+    if (i >= m_gameCount)
+        return false;
+    uint64_t offset = getU64(m_data + m_indexOffset + 8 * i);
+    uint64_t end = i + 1 < m_gameCount ? getU64(m_data + m_indexOffset + 8 * (i + 1)) : m_indexOffset;
+    if (offset < HEADER_SIZE || end > m_indexOffset || offset + 4 > end)
+        return false;
+
+    const uint8_t* p = m_data + offset;
+    const uint8_t* last = m_data + end;
+    game.result = p[0] <= UNKNOWN_RESULT ? static_cast<GameResult>(p[0]) : UNKNOWN_RESULT;
+    uint8_t flags = p[1];
+    int plies = getU16(p + 2);
+    p += 4;
+
+    if (flags & CUSTOM_START) {
+        if (last - p < static_cast<ptrdiff_t>(PACKED_SIZE))
+            return false;
+        PackedPosition packed;
+        std::memcpy(packed.bytes, p, PACKED_SIZE);
+        if (!unpackPosition(packed, game.start))
+            return false;
+        p += PACKED_SIZE;
+    } else {
+        game.start = standardStart();
+    }
+
+    game.moves.clear();
+    game.position = game.start;
+    for (int ply = 0; ply < plies; ++ply) {
+        if (p == last)
+            return false;
+        int piece = *p >> 4;
+        int move = *p++ & 15;
+        if (move == LONG_MOVE) {
+            if (p == last)
+                return false;
+            move += *p++;
+        }
+
+        Move m = decodeMove(game.position, piece, move);
+        if (m.isNull())
+            return false;
+        game.position.makeMove(m);
+        game.moves.push_back(m);
+    }
+    return true;
+}
+
+bool GameFile::readPosition(uint64_t i, Position& pos) const {
+    if (i >= m_positionCount)
+        return false;
+    PackedPosition packed;
+    std::memcpy(packed.bytes, m_data + m_positionsOffset + PACKED_SIZE * i, PACKED_SIZE);
+    return unpackPosition(packed, pos);
+}
@@ -0,0 +1,113 @@
+#ifndef GAMEFILE_H
+#define GAMEFILE_H
+
+// Compact binary game and position files, read through a memory mapping.
+//
+// Layout, all integers little-endian:
+//   header      "CHESSGDB", version, game and position counts, section offsets
+//   games       per game: result, flags, ply count, a packed start position
+//               when it is not the standard one, then a move code per ply
+//   index       one 64-bit file offset per game, so game i is found in O(1)
+//   positions   fixed 32-byte packed records, position i at a fixed stride
+//
+// A ply takes one byte: the moving piece's index among the side to move's
+// pieces in square order, and the move's index among the targets that piece
+// has by its movement rules alone. Long slider moves take a second byte.
+// Decoding costs one attack lookup and a king safety check per ply, not a
+// legal move generation.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+#include "Move.h"
+#include "Position.h"
+
+// Occupancy, one nibble per piece in square order, then the state bytes.
+struct PackedPosition {
+    uint8_t bytes[32];
+};
+
+// False if the position has more than 32 pieces.
+bool packPosition(const Position& pos, PackedPosition& packed);
+// False, leaving pos cleared, if the record does not hold a valid position.
+bool unpackPosition(const PackedPosition& packed, Position& pos);
+
+enum GameResult : uint8_t { WHITE_WINS, BLACK_WINS, DRAW, UNKNOWN_RESULT };
+
+// To and from the PGN result tokens "1-0", "0-1", "1/2-1/2" and "*"; any
+// other token is UNKNOWN_RESULT.
+GameResult parseResult(std::string_view result);
+const char* resultText(GameResult result);
+
+struct GameRecord {
+    Position start;
+    std::vector<Move> moves;
+    Position position;          // after the last move
+    GameResult result;
+
+    GameRecord() : result(UNKNOWN_RESULT) {}
+};
+
+class GameFileWriter {
+public:
+    GameFileWriter();
+    ~GameFileWriter();
+
+    GameFileWriter(const GameFileWriter&) = delete;
+    GameFileWriter& operator=(const GameFileWriter&) = delete;
+
+    bool open(const char* path);
+
+    // moves must be legal from start. Positions are kept apart from games
+    // and land in the positions section when the file is closed.
+    bool addGame(const Position& start, const std::vector<Move>& moves, GameResult result);
+    bool addPosition(const Position& pos);
+
+    // Write the index and header; false if any write failed.
+    bool close();
+
+    uint64_t gameCount() const { return m_gameOffsets.size(); }
+    uint64_t positionCount() const { return m_positionCount; }
+
+private:
+    std::FILE* m_file;
+    std::FILE* m_positions;         // spooled to a temporary file until close
+    std::vector<uint64_t> m_gameOffsets;
+    std::vector<uint8_t> m_record;
+    uint64_t m_offset;
+    uint64_t m_positionCount;
+    bool m_ok;
+};
+
+class GameFile {
+public:
+    GameFile();
+
+    GameFile(const GameFile&) = delete;
+    GameFile& operator=(const GameFile&) = delete;
+
+    // Map path read-only and check its header and index bounds.
+    bool open(const char* path);
+    void close();
+
+    uint64_t gameCount() const { return m_gameCount; }
+    uint64_t positionCount() const { return m_positionCount; }
+
+    // Decode game i, replaying it from its start; false if it is corrupt.
+    bool readGame(uint64_t i, GameRecord& game) const;
+    bool readPosition(uint64_t i, Position& pos) const;
+
+private:
+    MappedFile m_file;
+    const uint8_t* m_data;
+    size_t m_size;
+    uint64_t m_gameCount;
+    uint64_t m_positionCount;
+    uint64_t m_indexOffset;
+    uint64_t m_positionsOffset;
+};
+
+#endif // GAMEFILE_H
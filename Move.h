@@ -0,0 +1,108 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+// Packed 16-bit move: bits 0-5 from square, bits 6-11 to square, bits 12-15 flags.
+
+#include <cassert>
+#include <cstdint>
+#include "Bitboard.h"
+#include "Position.h"
+
+enum MoveFlag : uint8_t {
+    QUIET = 0,
+    DOUBLE_PAWN_PUSH = 1,
+    KING_CASTLE = 2,
+    QUEEN_CASTLE = 3,
+    CAPTURE = 4,
+    EP_CAPTURE = 5,
+    // Promotion flags: bit 3 set, low two bits select knight/bishop/rook/queen,
+    // bit 2 marks a capturing promotion.
+    PROMOTION = 8,
+    PROMO_KNIGHT = 8,
+    PROMO_BISHOP = 9,
+    PROMO_ROOK = 10,
+    PROMO_QUEEN = 11,
+    PROMO_CAPTURE_KNIGHT = 12,
+    PROMO_CAPTURE_BISHOP = 13,
+    PROMO_CAPTURE_ROOK = 14,
+    PROMO_CAPTURE_QUEEN = 15
+};
+
+class Move {
+public:
+    Move() : m_data(0) {}
+    Move(int from, int to, int flags = QUIET)
+        : m_data(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) {}
+
+    static Move fromRaw(uint16_t raw) { Move m; m.m_data = raw; return m; }
+    uint16_t raw() const { return m_data; }
+
+    int from() const { return m_data & 0x3F; }
+    int to() const { return (m_data >> 6) & 0x3F; }
+    int flags() const { return m_data >> 12; }
+
+    bool isNull() const { return m_data == 0; }
+    bool isCapture() const { return (flags() & CAPTURE) != 0; }
+    bool isPromotion() const { return (flags() & PROMOTION) != 0; }
+    bool isEnPassant() const { return flags() == EP_CAPTURE; }
+    bool isCastle() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+    PieceType promotionType() const { return static_cast<PieceType>(KNIGHT + (flags() & 3)); }
+
+    bool operator==(Move other) const { return m_data == other.m_data; }
+    bool operator!=(Move other) const { return m_data != other.m_data; }
+
+private:
+    uint16_t m_data;
+};
+
+// Write the move in UCI long algebraic form ("e2e4", "e7e8q") into out[6].
+inline void moveToUci(Move m, char out[6]) {
+    out[0] = static_cast<char>('a' + fileOf(m.from()));
+    out[1] = static_cast<char>('1' + rankOf(m.from()));
+    out[2] = static_cast<char>('a' + fileOf(m.to()));
+    out[3] = static_cast<char>('1' + rankOf(m.to()));
+    int len = 4;
+    if (m.isPromotion())
+        out[len++] = "nbrq"[m.promotionType() - KNIGHT];
+    out[len] = '\0';
+}
+
+// Upper bound on the number of legal moves in any reachable chess position.
+// Arbitrary placements can exceed it; the core relies on fromFen and
+// unpackPosition rejecting material no game can reach.
+const int MAX_MOVES = 218;
+
+// Fixed-capacity move buffer meant to live on the caller's stack.
+class MoveList {
+public:
+    MoveList() : m_size(0) {}
+
+    void add(Move m) {
+        assert(m_size < MAX_MOVES);
+        m_moves[m_size++] = m;
+    }
+    void clear() { m_size = 0; }
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    Move operator[](int i) const { return m_moves[i]; }
+    Move& operator[](int i) { return m_moves[i]; }
+
+    Move* begin() { return m_moves; }
+    Move* end() { return m_moves + m_size; }
+    const Move* begin() const { return m_moves; }
+    const Move* end() const { return m_moves + m_size; }
+
+    bool contains(Move m) const {
+        for (int i = 0; i < m_size; ++i)
+            if (m_moves[i] == m)
+                return true;
+        return false;
+    }
+
+private:
+    Move m_moves[MAX_MOVES];
+    int m_size;
+};
+
+#endif // MOVE_H
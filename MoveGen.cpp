@@ -0,0 +1,230 @@
+#include "MoveGen.h"
+#include "Attacks.h"
+
+// Checkers and pins are worked out once per position; every move is then
+// emitted only if it is legal, so nothing is made and unmade to test it.
+namespace {
+
+struct GenState {
+    Color us;
+    Color them;
+    int kingSq;
+    Bitboard occupied;
+    Bitboard own;
+    Bitboard enemies;
+    Bitboard checkers;
+    Bitboard pinned;
+    Bitboard targetMask;  // squares that resolve a single check, or all non-own squares
+};
+
+Bitboard pinnedPieces(const Position& pos, Color us, int kingSq, Bitboard occupied) {
+    Color them = ~us;
+    Bitboard queens = pos.pieces(them, QUEEN);
+    Bitboard snipers = (rookAttacks(kingSq, 0) & (pos.pieces(them, ROOK) | queens))
+                     | (bishopAttacks(kingSq, 0) & (pos.pieces(them, BISHOP) | queens));
+
+    Bitboard pinned = 0;
+    while (snipers) {
+        int sniper = popLsb(snipers);
+        Bitboard blockers = betweenBB(kingSq, sniper) & occupied;
+        if (blockers && !moreThanOne(blockers))
+            pinned |= blockers & pos.pieces(us);
+    }
+    return pinned;
+}
+
+// Pinned pieces may only slide along the line through their king
+inline Bitboard pinMask(const GenState& st, int from) {
+    return (st.pinned & squareBB(from)) ? lineBB(st.kingSq, from) : ~0ULL;
+}
+
+void addPromotions(MoveList& list, int from, int to, bool capture) {
+    int base = capture ? PROMO_CAPTURE_KNIGHT : PROMO_KNIGHT;
+    list.add(Move(from, to, base + 3));
+    list.add(Move(from, to, base + 2));
+    list.add(Move(from, to, base + 1));
+    list.add(Move(from, to, base));
+}
+
+// En passant removes two pieces from one rank, which can expose the king along
+// that rank, so test it against the resulting occupancy directly.
+bool isLegalEnPassant(const Position& pos, const GenState& st, int from, int to) {
+    int capturedSq = to + (st.us == WHITE ? -8 : 8);
+    Bitboard occupied = (st.occupied ^ squareBB(from) ^ squareBB(capturedSq)) | squareBB(to);
+    Bitboard queens = pos.pieces(st.them, QUEEN);
+
+    if (rookAttacks(st.kingSq, occupied) & (pos.pieces(st.them, ROOK) | queens))
+        return false;
+    if (bishopAttacks(st.kingSq, occupied) & (pos.pieces(st.them, BISHOP) | queens))
+        return false;
+
+    // Any remaining checker must be the pawn being captured
+    return (st.checkers & ~squareBB(capturedSq) & ~pos.pieces(st.them, ROOK)
+            & ~pos.pieces(st.them, BISHOP) & ~queens) == 0;
+}
+
+// CapturesOnly leaves out quiet moves other than promotions
+template <bool CapturesOnly>
+void generatePawnMoves(const Position& pos, const GenState& st, MoveList& list) {
+    int up = (st.us == WHITE) ? 8 : -8;
+    Bitboard startRank = rankBB(st.us == WHITE ? 1 : 6);
+    Bitboard lastRank = (st.us == WHITE) ? RANK_8_BB : RANK_1_BB;
+    int ep = pos.epSquare();
+
+    Bitboard pawns = pos.pieces(st.us, PAWN);
+    while (pawns) {
+        int from = popLsb(pawns);
+        Bitboard allowed = st.targetMask & pinMask(st, from);
+        int to = from + up;
+
+        if (pos.isEmpty(to)) {
+            if (allowed & squareBB(to)) {
+                if (squareBB(to) & lastRank)
+                    addPromotions(list, from, to, false);
+                else if (!CapturesOnly)
+                    list.add(Move(from, to));
+            }
+            if (!CapturesOnly && (squareBB(from) & startRank)
+                && pos.isEmpty(to + up) && (allowed & squareBB(to + up)))
+                list.add(Move(from, to + up, DOUBLE_PAWN_PUSH));
+        }
+
+        Bitboard captures = pawnAttacks(st.us, from) & st.enemies & allowed;
+        while (captures) {
+            int target = popLsb(captures);
+            if (squareBB(target) & lastRank)
+                addPromotions(list, from, target, true);
+            else
+                list.add(Move(from, target, CAPTURE));
+        }
+
+        if (ep != NO_SQUARE && (pawnAttacks(st.us, from) & squareBB(ep))
+            && isLegalEnPassant(pos, st, from, ep))
+            list.add(Move(from, ep, EP_CAPTURE));
+    }
+}
+
+template <bool CapturesOnly>
+void generatePieceMoves(const Position& pos, const GenState& st, MoveList& list) {
+    for (int pt = KNIGHT; pt <= QUEEN; ++pt) {
+        Bitboard pieces = pos.pieces(st.us, static_cast<PieceType>(pt));
+        while (pieces) {
+            int from = popLsb(pieces);
+            Bitboard targets = attacksFrom(static_cast<PieceType>(pt), from, st.occupied)
+                             & st.targetMask & pinMask(st, from);
+            if (CapturesOnly)
+                targets &= st.enemies;
+            while (targets) {
+                int to = popLsb(targets);
+                list.add(Move(from, to, (st.enemies & squareBB(to)) ? CAPTURE : QUIET));
+            }
+        }
+    }
+}
+
+template <bool CapturesOnly>
+void generateKingMoves(const Position& pos, const GenState& st, MoveList& list) {
+    // Lift the king off the board so sliders see through its current square
+    Bitboard occupied = st.occupied ^ squareBB(st.kingSq);
+    Bitboard targets = kingAttacks(st.kingSq) & (CapturesOnly ? st.enemies : ~st.own);
+    while (targets) {
+        int to = popLsb(targets);
+        if (!(pos.attackersTo(to, occupied) & st.enemies))
+            list.add(Move(st.kingSq, to, (st.enemies & squareBB(to)) ? CAPTURE : QUIET));
+    }
+}
+
+void generateCastling(const Position& pos, const GenState& st, MoveList& list) {
+    int rights = pos.castlingRights();
+    int kingSq = makeSquare(4, st.us == WHITE ? 0 : 7);
+    int kingside = (st.us == WHITE) ? WHITE_OO : BLACK_OO;
+    int queenside = (st.us == WHITE) ? WHITE_OOO : BLACK_OOO;
+
+    if ((rights & kingside)
+        && pos.isEmpty(kingSq + 1) && pos.isEmpty(kingSq + 2)
+        && !pos.isSquareAttacked(kingSq + 1, st.them)
+        && !pos.isSquareAttacked(kingSq + 2, st.them))
+        list.add(Move(kingSq, kingSq + 2, KING_CASTLE));
+
+    if ((rights & queenside)
+        && pos.isEmpty(kingSq - 1) && pos.isEmpty(kingSq - 2) && pos.isEmpty(kingSq - 3)
+        && !pos.isSquareAttacked(kingSq - 1, st.them)
+        && !pos.isSquareAttacked(kingSq - 2, st.them))
+        list.add(Move(kingSq, kingSq - 2, QUEEN_CASTLE));
+}
+
+template <bool CapturesOnly>
+void generateMoves(const Position& pos, MoveList& list) {
+    list.clear();
+
+    GenState st;
+    st.us = pos.sideToMove();
+    st.them = ~st.us;
+    st.kingSq = pos.kingSquare(st.us);
+    st.occupied = pos.occupied();
+    st.own = pos.pieces(st.us);
+    st.enemies = pos.pieces(st.them);
+    st.checkers = pos.attackersTo(st.kingSq, st.occupied) & st.enemies;
+    st.pinned = pinnedPieces(pos, st.us, st.kingSq, st.occupied);
+
+    generateKingMoves<CapturesOnly>(pos, st, list);
+
+    // In double check only the king can move
+    if (moreThanOne(st.checkers))
+        return;
+
+    if (st.checkers) {
+        int checker = lsb(st.checkers);
+        st.targetMask = betweenBB(st.kingSq, checker) | st.checkers;
+    } else {
+        st.targetMask = ~st.own;
+        if (!CapturesOnly)
+            generateCastling(pos, st, list);
+    }
+
+    generatePawnMoves<CapturesOnly>(pos, st, list);
+    generatePieceMoves<CapturesOnly>(pos, st, list);
+}
+
+} // namespace
+
+void generateLegalMoves(const Position& pos, MoveList& list) {
+    generateMoves<false>(pos, list);
+}
+
+void generateLegalCaptures(const Position& pos, MoveList& list) {
+    generateMoves<true>(pos, list);
+}
+
+Move makeMoveTo(const Position& pos, int from, int to, PieceType promotion) {
+    int capture = pos.isEmpty(to) ? 0 : CAPTURE;
+    switch (typeOf(pos.pieceOn(from))) {
+    case PAWN:
+        if (to == pos.epSquare())
+            return Move(from, to, EP_CAPTURE);
+        if (promotion != NO_PIECE_TYPE)
+            return Move(from, to, PROMOTION + (promotion - KNIGHT) + capture);
+        if (to - from == 16 || from - to == 16)
+            return Move(from, to, DOUBLE_PAWN_PUSH);
+        break;
+    case KING:
+        if (to - from == 2)
+            return Move(from, to, KING_CASTLE);
+        if (from - to == 2)
+            return Move(from, to, QUEEN_CASTLE);
+        break;
+    default:
+        break;
+    }
+    return Move(from, to, capture);
+}
+
+bool leavesKingSafe(const Position& pos, Move m) {
+    Color us = pos.sideToMove();
+    Bitboard captured = squareBB(m.to());
+    if (m.isEnPassant())
+        captured = squareBB(m.to() + (us == WHITE ? -8 : 8));
+    Bitboard occupied = (pos.occupied() & ~squareBB(m.from()) & ~captured) | squareBB(m.to());
+    int king = m.from() == pos.kingSquare(us) ? m.to() : pos.kingSquare(us);
+    return !(pos.attackersTo(king, occupied) & pos.pieces(~us) & ~captured);
+}
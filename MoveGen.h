@@ -0,0 +1,22 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "Move.h"
+#include "Position.h"
+
+// Fill list with every legal move for the side to move. Never allocates.
+void generateLegalMoves(const Position& pos, MoveList& list);
+
+// Only the legal captures, en-passant captures and promotions; for quiescence search.
+void generateLegalCaptures(const Position& pos, MoveList& list);
+
+// The move of the piece on from to to, flagged as the position implies:
+// capture, en passant, double push or castling. promotion is NO_PIECE_TYPE
+// unless a pawn reaches the last rank.
+Move makeMoveTo(const Position& pos, int from, int to, PieceType promotion = NO_PIECE_TYPE);
+
+// Whether a move that follows the piece's movement rules (castling aside)
+// leaves the mover's king out of check.
+bool leavesKingSafe(const Position& pos, Move m);
+
+#endif // MOVEGEN_H
@@ -7,8 +7,6 @@
 class Pawn : public ChessPiece {
 public:
     Pawn(PieceColor color, int row, int col);
-
-    QVector<QPair<int, int>> getValidMoves(const QVector<QVector<ChessPiece*>> &board) override;
 };
 
 
@@ -0,0 +1,25 @@
+#include "PawnTable.h"
+
+PawnTable::PawnTable(size_t kilobytes)
+    : m_mask(0), m_stats() {
+    resize(kilobytes);
+}
+
+// Rounded down to a power of two entries so the index is a mask
+void PawnTable::resize(size_t kilobytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(PawnEntry) <= (kilobytes << 10))
+        count *= 2;
+
+    m_entries.assign(count, PawnEntry());
+    m_mask = count - 1;
+    resetStats();
+}
+
+// A cleared slot holds key 0 with no pawns and no score, which is exactly
+// the entry of a position without pawns, so it needs no separate marker.
+void PawnTable::clear() {
+    for (PawnEntry& entry : m_entries)
+        entry = PawnEntry();
+    resetStats();
+}
@@ -0,0 +1,56 @@
+#ifndef PAWNTABLE_H
+#define PAWNTABLE_H
+
+// Cache of pawn-structure evaluation keyed by Position::pawnKey().
+//
+// Pawn moves are rare among the nodes of a search, so most evaluations find
+// their pawn terms here. Each search thread owns its own table, which keeps
+// it free of locks and atomics.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Bitboard.h"
+#include "Position.h"
+
+struct PawnEntry {
+    uint64_t key;
+    Score score;                  // White's point of view
+    Bitboard passed[COLOR_NB];
+};
+
+struct PawnTableStats {
+    uint64_t hits;
+    uint64_t misses;
+
+    double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
+
+class PawnTable {
+public:
+    explicit PawnTable(size_t kilobytes = 1024);
+
+    // Reallocate and clear.
+    void resize(size_t kilobytes);
+    void clear();
+    size_t sizeKilobytes() const { return m_entries.size() * sizeof(PawnEntry) >> 10; }
+
+    // The slot for key. found tells whether it already holds that key; on a
+    // miss the caller fills the slot in, key included.
+    PawnEntry* probe(uint64_t key, bool& found) {
+        PawnEntry* entry = &m_entries[key & m_mask];
+        found = entry->key == key;
+        ++(found ? m_stats.hits : m_stats.misses);
+        return entry;
+    }
+
+    PawnTableStats stats() const { return m_stats; }
+    void resetStats() { m_stats = PawnTableStats(); }
+
+private:
+    std::vector<PawnEntry> m_entries;
+    uint64_t m_mask;
+    PawnTableStats m_stats;
+};
+
+#endif // PAWNTABLE_H
@@ -0,0 +1,120 @@
+#include "Perft.h"
+#include "MoveGen.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+
+namespace {
+
+// Make/unmake on one working copy: no position is copied per move.
+uint64_t perftInPlace(Position& pos, int depth) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+
+    // Bulk counting: the generator is exact, so the last ply needs no make
+    if (depth <= 1)
+        return depth == 1 ? static_cast<uint64_t>(moves.size()) : 1;
+
+    uint64_t nodes = 0;
+    UndoInfo undo;
+    for (Move m : moves) {
+        pos.makeMove(m, undo);
+        nodes += perftInPlace(pos, depth - 1);
+        pos.unmakeMove(m, undo);
+    }
+    return nodes;
+}
+
+uint64_t hashPerftInPlace(Position& pos, int depth, TranspositionTable& tt) {
+    // Below this a subtree is cheaper to recount than to look up
+    if (depth < 2)
+        return perftInPlace(pos, depth);
+
+    uint64_t nodes;
+    if (tt.probePerft(pos.key(), depth, nodes))
+        return nodes;
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+
+    nodes = 0;
+    UndoInfo undo;
+    for (Move m : moves) {
+        pos.makeMove(m, undo);
+        nodes += hashPerftInPlace(pos, depth - 1, tt);
+        pos.unmakeMove(m, undo);
+    }
+    tt.storePerft(pos.key(), depth, nodes);
+    return nodes;
+}
+
+} // namespace
+
+uint64_t perft(const Position& pos, int depth) {
+    Position work = pos;
+    return perftInPlace(work, depth);
+}
+
+uint64_t perft(const Position& pos, int depth, TranspositionTable& tt) {
+    Position work = pos;
+    return hashPerftInPlace(work, depth, tt);
+}
+
+namespace {
+
+// Subtrees this shallow are cheaper to count in place than to schedule.
+const int SERIAL_DEPTH = 3;
+
+struct PerftJob {
+    ThreadPool* pool;
+    TaskGroup* group;
+    std::atomic<uint64_t>* nodes;
+    TranspositionTable* tt;
+};
+
+void splitPerft(const PerftJob& job, const Position& pos, int depth) {
+    // Split one level deeper only while some worker has nothing to do
+    bool split = depth > SERIAL_DEPTH + 1
+              || (depth == SERIAL_DEPTH + 1 && job.pool->idleWorkers() > 0);
+    if (!split) {
+        uint64_t nodes = job.tt ? perft(pos, depth, *job.tt) : perft(pos, depth);
+        job.nodes->fetch_add(nodes, std::memory_order_relaxed);
+        return;
+    }
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    for (Move m : moves) {
+        Position next = pos;
+        next.makeMove(m);
+        job.pool->submit(*job.group, [job, next, depth] {
+            splitPerft(job, next, depth - 1);
+        });
+    }
+}
+
+} // namespace
+
+uint64_t perftParallel(const Position& pos, int depth, ThreadPool& pool, TranspositionTable* tt) {
+    if (depth <= SERIAL_DEPTH || pool.threadCount() == 1)
+        return tt ? perft(pos, depth, *tt) : perft(pos, depth);
+
+    std::atomic<uint64_t> nodes(0);
+    TaskGroup group;
+    PerftJob job = {&pool, &group, &nodes, tt};
+
+    // Always split the root; deeper levels decide for themselves
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    for (Move m : moves) {
+        Position next = pos;
+        next.makeMove(m);
+        pool.submit(group, [job, next, depth] {
+            splitPerft(job, next, depth - 1);
+        });
+    }
+
+    pool.wait(group);
+    return nodes.load();
+}
@@ -0,0 +1,20 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <cstdint>
+#include "Position.h"
+
+class ThreadPool;
+class TranspositionTable;
+
+// Number of leaf nodes of the legal move tree below pos at the given depth.
+uint64_t perft(const Position& pos, int depth);
+
+// Hash-perft: subtree counts are cached in tt, so transpositions are counted once.
+uint64_t perft(const Position& pos, int depth, TranspositionTable& tt);
+
+// Same count, with subtrees split into tasks on the pool. The total is
+// independent of thread count and scheduling. All threads share tt if given.
+uint64_t perftParallel(const Position& pos, int depth, ThreadPool& pool, TranspositionTable* tt = nullptr);
+
+#endif // PERFT_H
@@ -0,0 +1,366 @@
+#include "Pgn.h"
+#include "San.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+const char* const sevenTagRoster[7] = {"Event", "Site", "Date", "Round", "White", "Black", "Result"};
+
+inline bool isPgnSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Movetext tokens end at whitespace and at characters with a meaning of their own
+inline bool endsToken(char c) {
+    return isPgnSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == '[' || c == ']' || c == ';'
+        || c == '$';
+}
+
+inline bool isResult(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// Index just past the end of the line holding i, or npos if it runs off the text
+size_t lineEnd(std::string_view text, size_t i) {
+    size_t end = text.find('\n', i);
+    return end == std::string_view::npos ? end : end + 1;
+}
+
+// Parse a line holding one tag pair, '[' first; false if it is malformed
+bool parseTag(std::string_view line, PgnTag& tag) {
+    size_t i = 1;
+    size_t n = line.size();
+    while (i < n && (line[i] == ' ' || line[i] == '\t'))
+        ++i;
+    size_t nameStart = i;
+    while (i < n && (std::isalnum(static_cast<unsigned char>(line[i])) || line[i] == '_'))
+        ++i;
+    if (i == nameStart)
+        return false;
+    tag.name = line.substr(nameStart, i - nameStart);
+
+    while (i < n && (line[i] == ' ' || line[i] == '\t'))
+        ++i;
+    if (i >= n || line[i] != '"')
+        return false;
+    size_t valueStart = ++i;
+    while (i < n && line[i] != '"')
+        i += line[i] == '\\' ? 2 : 1;
+    if (i >= n)
+        return false;
+    tag.value = line.substr(valueStart, i - valueStart);
+
+    ++i;
+    while (i < n && (line[i] == ' ' || line[i] == '\t'))
+        ++i;
+    return i < n && line[i] == ']';
+}
+
+void setError(PgnGame& game, const char* error, std::string_view token) {
+    if (game.error)
+        return;
+    game.error = error;
+    game.errorToken = token;
+}
+
+// The start position comes from the FEN tag, so it is set up once the tags are read
+void setUpStart(PgnGame& game) {
+    std::string_view fen = game.tag("FEN");
+    if (fen.empty()) {
+        game.start.setStartPosition();
+    } else if (!game.start.fromFen(fen).ok()) {
+        game.start.setStartPosition();
+        setError(game, "invalid FEN tag", fen);
+    }
+    game.position = game.start;
+    game.keys.reset(game.position.key());
+    game.draw = drawByRule(game.position, game.keys);
+    game.drawPly = 0;
+}
+
+// Record a replayed move, and the first draw by rule it reaches
+void playMove(PgnGame& game, Move m) {
+    game.position.makeMove(m);
+    game.moves.push_back(m);
+    game.keys.push(game.position.key());
+    if (game.draw == NO_DRAW) {
+        game.draw = drawByRule(game.position, game.keys);
+        if (game.draw != NO_DRAW)
+            game.drawPly = static_cast<uint32_t>(game.moves.size());
+    }
+}
+
+// Only the final position can be stalemate, or checkmate with the fifty-move
+// count run out
+void finishGame(PgnGame& game) {
+    if (game.draw == NO_DRAW || game.drawPly == game.moves.size()) {
+        game.draw = drawReason(game.position, game.keys);
+        game.drawPly = static_cast<uint32_t>(game.moves.size());
+    }
+}
+
+void appendTag(std::string& out, std::string_view name, std::string_view value) {
+    out += '[';
+    out.append(name.data(), name.size());
+    out += " \"";
+    out.append(value.data(), value.size());
+    out += "\"]\n";
+}
+
+} // namespace
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    for (const PgnTag& t : tags)
+        if (t.name == name)
+            return t.value;
+    return std::string_view();
+}
+
+size_t parsePgnGame(std::string_view text, bool atEnd, PgnGame& game) {
+    game.tags.clear();
+    game.moves.clear();
+    game.result = std::string_view();
+    game.error = nullptr;
+    game.errorToken = std::string_view();
+    game.offset = 0;
+
+    size_t n = text.size();
+    size_t i = 0;
+    bool started = false;
+    bool inMovetext = false;
+
+    while (i < n) {
+        char c = text[i];
+        if (isPgnSpace(c)) {
+            ++i;
+            continue;
+        }
+
+        // Comments, and escape lines with '%' in the first column
+        if (c == ';' || (c == '%' && (i == 0 || text[i - 1] == '\n'))) {
+            i = lineEnd(text, i);
+            if (i == std::string_view::npos)
+                break;
+            continue;
+        }
+        if (c == '{') {
+            i = text.find('}', i);
+            if (i == std::string_view::npos)
+                break;
+            ++i;
+            continue;
+        }
+
+        if (!started) {
+            game.offset = i;
+            started = true;
+        }
+
+        if (c == '[') {
+            // A tag after the movetext starts the next game, whose
+            // predecessor had no termination marker
+            if (inMovetext) {
+                game.result = "*";
+                finishGame(game);
+                return i;
+            }
+            size_t end = lineEnd(text, i);
+            if (end == std::string_view::npos) {
+                if (!atEnd)
+                    return 0;
+                end = n;
+            }
+            std::string_view line = text.substr(i, end - i);
+            PgnTag tag;
+            if (parseTag(line, tag))
+                game.tags.push_back(tag);
+            else
+                setError(game, "malformed tag pair", line);
+            i = end;
+            continue;
+        }
+
+        if (!inMovetext) {
+            setUpStart(game);
+            inMovetext = true;
+        }
+
+        // Variations are skipped, comments in them included
+        if (c == '(') {
+            int depth = 0;
+            for (; i < n; ++i) {
+                if (text[i] == '(') {
+                    ++depth;
+                } else if (text[i] == ')') {
+                    if (--depth == 0)
+                        break;
+                } else if (text[i] == '{') {
+                    i = text.find('}', i);
+                    if (i == std::string_view::npos)
+                        i = n - 1;
+                }
+            }
+            if (i >= n)
+                break;
+            ++i;
+            continue;
+        }
+
+        // Numeric annotation glyph
+        if (c == '$') {
+            ++i;
+            while (i < n && isDigit(text[i]))
+                ++i;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < n && !endsToken(text[i]))
+            ++i;
+        if (i == start) {
+            setError(game, "unexpected character in movetext", text.substr(i, 1));
+            ++i;
+            continue;
+        }
+        // The token may go on past the end of the text read so far
+        if (i == n && !atEnd)
+            return 0;
+        std::string_view token = text.substr(start, i - start);
+
+        if (isResult(token)) {
+            game.result = token;
+            finishGame(game);
+            return i;
+        }
+
+        // Move numbers, "12." or "12...", sometimes run into the move itself
+        size_t k = 0;
+        if (isDigit(token[0]) && token.substr(0, 3) != "0-0")
+            while (k < token.size() && isDigit(token[k]))
+                ++k;
+        while (k < token.size() && token[k] == '.')
+            ++k;
+        token.remove_prefix(k);
+        if (token.empty() || game.error)
+            continue;
+
+        Move m = parseSan(game.position, token);
+        if (m.isNull()) {
+            setError(game, "illegal or ambiguous move", token);
+            continue;
+        }
+        playMove(game, m);
+    }
+
+    // Out of text: the last game only ends here if nothing more is coming
+    if (!atEnd || !started)
+        return 0;
+    if (!inMovetext)
+        setUpStart(game);
+    game.result = "*";
+    finishGame(game);
+    return n;
+}
+
+PgnReader::PgnReader(std::FILE* file, size_t bufferSize)
+    : m_file(file), m_buffer(bufferSize > 0 ? bufferSize : 1), m_begin(0), m_end(0), m_offset(0), m_games(0),
+      m_eof(false) {
+    refill();
+    // Skip a UTF-8 byte order mark
+    if (m_end >= 3 && std::memcmp(m_buffer.data(), "\xEF\xBB\xBF", 3) == 0)
+        m_begin = 3;
+}
+
+bool PgnReader::next(PgnGame& game) {
+    for (;;) {
+        std::string_view text(m_buffer.data() + m_begin, m_end - m_begin);
+        size_t used = parsePgnGame(text, m_eof, game);
+        if (used) {
+            game.offset += m_offset + m_begin;
+            m_begin += used;
+            ++m_games;
+            return true;
+        }
+        if (m_eof)
+            return false;
+        refill();
+    }
+}
+
+// Move the unparsed tail to the front and read behind it, growing the
+// buffer only when one game fills all of it
+void PgnReader::refill() {
+    if (m_begin > 0) {
+        std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+        m_offset += m_begin;
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+    if (m_end == m_buffer.size())
+        m_buffer.resize(m_buffer.size() * 2);
+
+    size_t got = std::fread(m_buffer.data() + m_end, 1, m_buffer.size() - m_end, m_file);
+    m_end += got;
+    if (got == 0)
+        m_eof = true;
+}
+
+void writePgn(std::string& out, const PgnGame& game) {
+    std::string_view result = game.result.empty() ? std::string_view("*") : game.result;
+    for (const char* name : sevenTagRoster) {
+        std::string_view value = std::strcmp(name, "Result") ? game.tag(name) : result;
+        if (value.empty())
+            value = std::strcmp(name, "Date") ? "?" : "????.??.??";
+        appendTag(out, name, value);
+    }
+    for (const PgnTag& t : game.tags) {
+        bool inRoster = false;
+        for (const char* name : sevenTagRoster)
+            inRoster |= t.name == name;
+        if (!inRoster)
+            appendTag(out, t.name, t.value);
+    }
+
+    Position standard;
+    standard.setStartPosition();
+    if (game.tag("FEN").empty() && game.start.key() != standard.key()) {
+        char fen[MAX_FEN_LENGTH];
+        appendTag(out, "SetUp", "1");
+        appendTag(out, "FEN", std::string_view(fen, game.start.toFen(fen)));
+    }
+    out += '\n';
+
+    // Tokens are separated by single spaces and lines kept under 80 columns
+    size_t lineStart = out.size();
+    auto append = [&out, &lineStart](const char* token, size_t length) {
+        if (out.size() > lineStart) {
+            if (out.size() - lineStart + 1 + length >= 80) {
+                out += '\n';
+                lineStart = out.size();
+            } else {
+                out += ' ';
+            }
+        }
+        out.append(token, length);
+    };
+
+    // A move number stays on the same line as its move
+    Position pos = game.start;
+    for (size_t k = 0; k < game.moves.size(); ++k) {
+        char token[16 + MAX_SAN_LENGTH];
+        int length = 0;
+        if (pos.sideToMove() == WHITE || k == 0)
+            length = std::snprintf(token, 16, pos.sideToMove() == WHITE ? "%d. " : "%d... ", pos.fullmoveNumber());
+        size_t total = static_cast<size_t>(length) + moveToSan(pos, game.moves[k], token + length);
+        append(token, total);
+        pos.makeMove(game.moves[k]);
+    }
+    append(result.data(), result.size());
+    out += "\n\n";
+}
@@ -0,0 +1,92 @@
+#ifndef PGN_H
+#define PGN_H
+
+// Streaming reader and writer for Portable Game Notation.
+//
+// PgnReader pulls a file through one buffer, a game at a time, and replays
+// every game's movetext through the legal move generator. Tags point into
+// that buffer and the move list is reused from game to game, so memory
+// stays flat however large the file is.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Draw.h"
+#include "Move.h"
+#include "Position.h"
+
+// A tag pair; the value is kept as written, escapes included.
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;
+};
+
+struct PgnGame {
+    std::vector<PgnTag> tags;
+    Position start;                 // from the FEN tag, else the standard start
+    std::vector<Move> moves;        // replayed from start, up to the first bad move
+    Position position;              // after the last replayed move
+    std::string_view result;        // "1-0", "0-1", "1/2-1/2" or "*"
+
+    // The first draw by rule the replay reached, and after how many plies,
+    // whatever the recorded result says
+    DrawReason draw;
+    uint32_t drawPly;
+    RepetitionHistory keys;         // of the replayed positions
+
+    // Null when the whole game replayed; otherwise what went wrong and the
+    // movetext token (or tag) it went wrong at.
+    const char* error;
+    std::string_view errorToken;
+
+    uint64_t offset;                // of the game's first byte in the input
+
+    PgnGame() : draw(NO_DRAW), drawPly(0), error(nullptr), offset(0) {}
+
+    bool ok() const { return error == nullptr; }
+    // Value of the named tag, empty if the game does not have it.
+    std::string_view tag(std::string_view name) const;
+};
+
+// Parse and replay the first game in text. Returns the number of bytes it
+// took, or 0 if text holds no complete game: unless atEnd, a game that runs
+// to the end of text without a termination marker may continue past it.
+// game.offset is relative to text. The game's views point into text.
+size_t parsePgnGame(std::string_view text, bool atEnd, PgnGame& game);
+
+class PgnReader {
+public:
+    // Reads file, which stays owned by the caller, bufferSize bytes at a
+    // time. The buffer only grows for a single game longer than that.
+    explicit PgnReader(std::FILE* file, size_t bufferSize = 1 << 20);
+
+    // Parse and replay the next game into game; false at the end of the
+    // input. The game's views stay valid until the next call.
+    bool next(PgnGame& game);
+
+    uint64_t bytesRead() const { return m_offset + m_end; }
+    uint64_t gamesRead() const { return m_games; }
+    bool readError() const { return std::ferror(m_file) != 0; }
+
+private:
+    void refill();
+
+    std::FILE* m_file;
+    std::vector<char> m_buffer;
+    size_t m_begin;         // first unparsed byte
+    size_t m_end;           // end of the data read so far
+    uint64_t m_offset;      // input offset of m_buffer[0]
+    uint64_t m_games;
+    bool m_eof;
+};
+
+// Append game as PGN export format: the seven-tag roster ("?" where the game
+// lacks one) and its other tags, SetUp and FEN tags when it does not start
+// from the standard position, then the movetext from start wrapped at 80
+// columns and the result.
+void writePgn(std::string& out, const PgnGame& game);
+
+#endif // PGN_H
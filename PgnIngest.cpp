@@ -0,0 +1,176 @@
+#include "PgnIngest.h"
+#include "Pgn.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Chunk {
+    uint64_t sequence;
+    uint64_t offset;            // of text[0] in the input
+    std::vector<char> text;
+    std::vector<PgnGameSummary> games;
+};
+
+// Start of the last line in text that begins with '[' right after a blank
+// line, or 0 if there is none
+size_t lastGameStart(const std::vector<char>& text) {
+    for (size_t i = text.size(); i-- > 1;) {
+        if (text[i] != '[' || text[i - 1] != '\n')
+            continue;
+        size_t j = i - 1;
+        while (j > 0 && (text[j - 1] == ' ' || text[j - 1] == '\t' || text[j - 1] == '\r'))
+            --j;
+        if (j > 0 && text[j - 1] == '\n')
+            return i;
+    }
+    return 0;
+}
+
+void copyText(std::string_view from, char* to, size_t size) {
+    size_t n = std::min(from.size(), size - 1);
+    std::memcpy(to, from.data(), n);
+    to[n] = '\0';
+}
+
+void parseChunk(Chunk& chunk) {
+    // Reused across the chunks a worker parses, like PgnReader's game
+    thread_local PgnGame game;
+
+    std::string_view text(chunk.text.data(), chunk.text.size());
+    size_t at = 0;
+    while (size_t used = parsePgnGame(text.substr(at), true, game)) {
+        chunk.games.emplace_back();
+        PgnGameSummary& summary = chunk.games.back();
+        summary.offset = chunk.offset + at + game.offset;
+        summary.finalKey = game.position.key();
+        summary.plies = static_cast<uint32_t>(game.moves.size());
+        summary.drawPly = game.drawPly;
+        summary.draw = game.draw;
+        summary.error = game.error;
+        copyText(game.errorToken, summary.errorToken, sizeof(summary.errorToken));
+        copyText(game.result, summary.result, sizeof(summary.result));
+        game.position.toFen(summary.finalFen);
+        at += used;
+    }
+}
+
+} // namespace
+
+PgnIngestStats ingestPgn(std::FILE* file, const PgnIngestOptions& options,
+                         const std::function<void(const PgnGameSummary&)>& sink) {
+    int workers = std::max(1, options.threads);
+    size_t limit = options.chunksInFlight > 0 ? static_cast<size_t>(options.chunksInFlight) : 2 * workers;
+    size_t chunkSize = std::max<size_t>(options.chunkSize, 1);
+    PgnIngestStats stats = {0, 0, 0, false};
+
+    // The calling thread only reads and delivers, so every pool thread but it parses
+    ThreadPool pool(workers + 1);
+    TaskGroup group;
+
+    std::mutex mutex;
+    std::condition_variable chunkDone;
+    std::map<uint64_t, std::unique_ptr<Chunk>> done;    // by sequence
+    size_t inFlight = 0;
+    uint64_t nextSequence = 0;
+    std::vector<std::vector<char>> spareBuffers;
+
+    // Pass finished chunks to the sink, in sequence if ordered. With wait,
+    // block until at least one has been passed on.
+    auto deliver = [&](bool wait) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            auto it = options.ordered ? done.find(nextSequence) : done.begin();
+            if (it == done.end()) {
+                if (!wait)
+                    return;
+                chunkDone.wait(lock);
+                continue;
+            }
+            std::unique_ptr<Chunk> chunk = std::move(it->second);
+            done.erase(it);
+            lock.unlock();
+
+            for (const PgnGameSummary& game : chunk->games) {
+                ++stats.games;
+                stats.failed += game.error != nullptr;
+                sink(game);
+            }
+            spareBuffers.push_back(std::move(chunk->text));
+            --inFlight;
+            ++nextSequence;
+            wait = false;
+            lock.lock();
+        }
+    };
+
+    std::vector<char> pending;      // read but not yet cut into a chunk
+    uint64_t pendingOffset = 0;
+    uint64_t sequence = 0;
+    bool eof = false;
+    while (!eof) {
+        // Read until a game starts in what is pending, or the input ends
+        size_t cut = 0;
+        while (!eof && cut == 0) {
+            size_t old = pending.size();
+            pending.resize(old + chunkSize);
+            size_t got = std::fread(pending.data() + old, 1, chunkSize, file);
+            pending.resize(old + got);
+            stats.bytes += got;
+            eof = got == 0;
+            // Skip a UTF-8 byte order mark
+            if (stats.bytes == got && got >= 3 && std::memcmp(pending.data(), "\xEF\xBB\xBF", 3) == 0) {
+                pending.erase(pending.begin(), pending.begin() + 3);
+                pendingOffset = 3;
+            }
+            cut = lastGameStart(pending);
+        }
+        if (eof)
+            cut = pending.size();
+        if (cut == 0)
+            break;
+
+        std::unique_ptr<Chunk> chunk(new Chunk);
+        chunk->sequence = sequence++;
+        chunk->offset = pendingOffset;
+        chunk->text = std::move(pending);
+        if (spareBuffers.empty()) {
+            pending = std::vector<char>();
+        } else {
+            pending = std::move(spareBuffers.back());
+            spareBuffers.pop_back();
+        }
+        pending.assign(chunk->text.begin() + cut, chunk->text.end());
+        chunk->text.resize(cut);
+        pendingOffset += cut;
+
+        while (inFlight >= limit)
+            deliver(true);
+        ++inFlight;
+        Chunk* task = chunk.release();
+        pool.submit(group, [task, &mutex, &done, &chunkDone] {
+            parseChunk(*task);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done[task->sequence].reset(task);
+            }
+            chunkDone.notify_one();
+        });
+        deliver(false);
+    }
+
+    while (inFlight > 0)
+        deliver(true);
+    pool.wait(group);
+
+    stats.readError = std::ferror(file) != 0;
+    return stats;
+}
@@ -0,0 +1,55 @@
+#ifndef PGNINGEST_H
+#define PGNINGEST_H
+
+// Parallel PGN ingestion: the calling thread reads the input and cuts it
+// into chunks that end between games, pool workers parse and replay the
+// chunks, and the calling thread hands every game's summary to a sink.
+//
+// At most a fixed number of chunks are in flight, counting those whose
+// results wait for the sink, so reading blocks while the workers or the
+// sink fall behind and memory stays bounded.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include "Draw.h"
+#include "Position.h"
+
+struct PgnGameSummary {
+    uint64_t offset;            // of the game's first byte in the input
+    uint64_t finalKey;          // Zobrist key after the last replayed move
+    uint32_t plies;             // moves replayed
+    uint32_t drawPly;           // when draw is set, the ply that reached it
+    DrawReason draw;            // the first draw by rule in the replay
+    const char* error;          // as in PgnGame, null when the game replayed
+    char errorToken[32];        // the offending token, cut to fit
+    char result[8];             // termination marker
+    char finalFen[MAX_FEN_LENGTH];
+};
+
+struct PgnIngestOptions {
+    int threads = 1;            // parsing workers, besides the calling thread
+    size_t chunkSize = 1 << 20;
+    int chunksInFlight = 0;     // 0 picks twice the worker count
+    bool ordered = true;        // deliver games in input order
+};
+
+struct PgnIngestStats {
+    uint64_t games;
+    uint64_t failed;
+    uint64_t bytes;
+    bool readError;
+};
+
+// Ingest every game of file. sink runs on the calling thread only, so it
+// needs no locking; unless options.ordered, games arrive chunk by chunk in
+// whatever order the chunks finish.
+//
+// Chunks are only cut where a line starting with '[' follows a blank line,
+// as between games in export format. A game longer than a chunk makes its
+// chunk grow.
+PgnIngestStats ingestPgn(std::FILE* file, const PgnIngestOptions& options,
+                         const std::function<void(const PgnGameSummary&)>& sink);
+
+#endif // PGNINGEST_H
@@ -0,0 +1,608 @@
+#include "Position.h"
+
+#include <algorithm>
+#include "Attacks.h"
+#include "Move.h"
+
+Position::Position() {
+    clear();
+}
+
+void Position::clear() {
+    for (int c = 0; c < COLOR_NB; ++c) {
+        m_colors[c] = 0;
+        for (int pt = 0; pt < PIECE_TYPE_NB; ++pt)
+            m_pieces[c][pt] = 0;
+    }
+    for (int sq = 0; sq < 64; ++sq)
+        m_board[sq] = NO_PIECE;
+    m_kingSquare[WHITE] = m_kingSquare[BLACK] = NO_SQUARE;
+
+    m_sideToMove = WHITE;
+    m_castlingRights = NO_CASTLING;
+    m_epSquare = NO_SQUARE;
+    m_halfmoveClock = 0;
+    m_fullmoveNumber = 1;
+    m_key = 0;
+    m_pawnKey = 0;
+    m_psq = 0;
+    m_phase = 0;
+}
+
+void Position::setStartPosition() {
+    clear();
+
+    const PieceType backRank[8] = {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK};
+    for (int file = 0; file < 8; ++file) {
+        putPiece(makePiece(WHITE, backRank[file]), makeSquare(file, 0));
+        putPiece(makePiece(WHITE, PAWN), makeSquare(file, 1));
+        putPiece(makePiece(BLACK, PAWN), makeSquare(file, 6));
+        putPiece(makePiece(BLACK, backRank[file]), makeSquare(file, 7));
+    }
+
+    setCastlingRights(ALL_CASTLING);
+}
+
+namespace {
+
+const char pieceLetters[] = "PNBRQKpnbrqk";
+
+// Piece code of each FEN byte, NO_PIECE for anything that is not a piece
+struct FenPieceCodes {
+    Piece codes[256];
+
+    FenPieceCodes() {
+        for (int c = 0; c < 256; ++c)
+            codes[c] = NO_PIECE;
+        for (int i = 0; i < 12; ++i)
+            codes[static_cast<unsigned char>(pieceLetters[i])] = static_cast<Piece>(i);
+    }
+};
+
+const FenPieceCodes fenPieceCodes;
+
+inline bool isFenSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Read a move clock; false on overflow or when there are no digits
+bool parseClock(std::string_view fen, size_t& i, uint16_t& out) {
+    size_t start = i;
+    uint32_t value = 0;
+    while (i < fen.size() && fen[i] >= '0' && fen[i] <= '9') {
+        value = value * 10 + static_cast<uint32_t>(fen[i++] - '0');
+        if (value > 0xFFFF)
+            return false;
+    }
+    out = static_cast<uint16_t>(value);
+    return i > start;
+}
+
+char* writeNumber(char* out, unsigned value) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n)
+        *out++ = digits[--n];
+    return out;
+}
+
+} // namespace
+
+bool Position::hasReachableMaterial() const {
+    for (Color c : {WHITE, BLACK}) {
+        int pawns = popCount(m_pieces[c][PAWN]);
+        if (popCount(m_colors[c]) > 16 || pawns > 8)
+            return false;
+        int promoted = std::max(popCount(m_pieces[c][QUEEN]) - 1, 0)
+                     + std::max(popCount(m_pieces[c][ROOK]) - 2, 0)
+                     + std::max(popCount(m_pieces[c][BISHOP]) - 2, 0)
+                     + std::max(popCount(m_pieces[c][KNIGHT]) - 2, 0);
+        if (promoted > 8 - pawns)
+            return false;
+    }
+    return true;
+}
+
+// Fails at the first bad byte and leaves the position cleared
+FenError Position::fromFen(std::string_view fen) {
+    clear();
+
+    size_t i = 0;
+    size_t n = fen.size();
+    auto fail = [this, &i](const char* message) {
+        clear();
+        return FenError{message, i};
+    };
+
+    while (i < n && isFenSpace(fen[i]))
+        ++i;
+    if (i >= n)
+        return fail("empty FEN");
+
+    // Piece placement, rank 8 first. Pieces go straight into the bitboards;
+    // the colour sets and the hash terms are summed up once at the end.
+    uint64_t key = 0;
+    Score psq = 0;
+    int phase = 0;
+    int rank = 7;
+    int file = 0;
+    for (; i < n && !isFenSpace(fen[i]); ++i) {
+        unsigned char c = static_cast<unsigned char>(fen[i]);
+        if (static_cast<unsigned>(c - '1') < 8) {
+            file += c - '0';
+            if (file > 8)
+                return fail("rank has more than 8 squares");
+        } else if (c == '/') {
+            if (file != 8)
+                return fail("rank does not have 8 squares");
+            if (rank == 0)
+                return fail("more than 8 ranks");
+            --rank;
+            file = 0;
+        } else {
+            Piece pc = fenPieceCodes.codes[c];
+            if (pc == NO_PIECE)
+                return fail("unexpected character in piece placement");
+            if (file > 7)
+                return fail("rank has more than 8 squares");
+            int sq = makeSquare(file++, rank);
+            m_pieces[colorOf(pc)][typeOf(pc)] |= squareBB(sq);
+            m_board[sq] = pc;
+            key ^= zobristPiece[pc][sq];
+            psq += psqTable[pc][sq];
+            phase += phaseWeight[typeOf(pc)];
+        }
+    }
+    if (file != 8)
+        return fail("rank does not have 8 squares");
+    if (rank != 0)
+        return fail("fewer than 8 ranks");
+
+    for (int c = WHITE; c <= BLACK; ++c)
+        for (int pt = PAWN; pt <= KING; ++pt)
+            m_colors[c] |= m_pieces[c][pt];
+    m_key ^= key;
+    m_psq += psq;
+    m_phase += phase;
+
+    if (popCount(m_pieces[WHITE][KING]) != 1 || popCount(m_pieces[BLACK][KING]) != 1)
+        return fail("each side needs exactly one king");
+    if ((m_pieces[WHITE][PAWN] | m_pieces[BLACK][PAWN]) & (RANK_1_BB | RANK_8_BB))
+        return fail("pawn on the first or last rank");
+    if (!hasReachableMaterial())
+        return fail("more pieces than promotions allow");
+
+    m_kingSquare[WHITE] = static_cast<uint8_t>(lsb(m_pieces[WHITE][KING]));
+    m_kingSquare[BLACK] = static_cast<uint8_t>(lsb(m_pieces[BLACK][KING]));
+    m_pawnKey = 0;
+    for (int c = WHITE; c <= BLACK; ++c) {
+        Bitboard pawns = m_pieces[c][PAWN];
+        while (pawns) {
+            int sq = popLsb(pawns);
+            m_pawnKey ^= zobristPiece[makePiece(static_cast<Color>(c), PAWN)][sq];
+        }
+    }
+
+    // Side to move
+    while (i < n && isFenSpace(fen[i]))
+        ++i;
+    if (i >= n)
+        return fail("missing side to move");
+    if (fen[i] == 'w')
+        setSideToMove(WHITE);
+    else if (fen[i] == 'b')
+        setSideToMove(BLACK);
+    else
+        return fail("side to move must be 'w' or 'b'");
+    ++i;
+    if (i < n && !isFenSpace(fen[i]))
+        return fail("side to move must be 'w' or 'b'");
+
+    if (isSquareAttacked(m_kingSquare[~m_sideToMove], m_sideToMove))
+        return fail("side not to move is in check");
+
+    // Castling rights, which need the king and rook still on their squares
+    while (i < n && isFenSpace(fen[i]))
+        ++i;
+    if (i >= n)
+        return fail("missing castling rights");
+    int rights = NO_CASTLING;
+    if (fen[i] == '-') {
+        ++i;
+    } else {
+        for (; i < n && !isFenSpace(fen[i]); ++i) {
+            int right;
+            int kingSq;
+            int rookSq;
+            switch (fen[i]) {
+            case 'K': right = WHITE_OO;  kingSq = 4;  rookSq = 7;  break;
+            case 'Q': right = WHITE_OOO; kingSq = 4;  rookSq = 0;  break;
+            case 'k': right = BLACK_OO;  kingSq = 60; rookSq = 63; break;
+            case 'q': right = BLACK_OOO; kingSq = 60; rookSq = 56; break;
+            default: return fail("unexpected character in castling rights");
+            }
+            if (rights & right)
+                return fail("castling right given twice");
+            Color c = (right & (WHITE_OO | WHITE_OOO)) ? WHITE : BLACK;
+            if (m_board[kingSq] != makePiece(c, KING) || m_board[rookSq] != makePiece(c, ROOK))
+                return fail("castling right without king and rook on their squares");
+            rights |= right;
+        }
+    }
+    setCastlingRights(rights);
+
+    // En-passant target square
+    while (i < n && isFenSpace(fen[i]))
+        ++i;
+    if (i >= n)
+        return fail("missing en-passant square");
+    if (fen[i] == '-') {
+        ++i;
+    } else {
+        if (i + 1 >= n || fen[i] < 'a' || fen[i] > 'h')
+            return fail("malformed en-passant square");
+        // The square behind a pawn that has just moved two squares
+        int epRank = m_sideToMove == WHITE ? 5 : 2;
+        if (fen[i + 1] != '1' + epRank)
+            return fail("en-passant square on the wrong rank");
+        int sq = makeSquare(fen[i] - 'a', epRank);
+        int pawnSq = sq + (m_sideToMove == WHITE ? -8 : 8);
+        if (m_board[pawnSq] != makePiece(~m_sideToMove, PAWN) || m_board[sq] != NO_PIECE)
+            return fail("en-passant square without a pawn that just moved");
+        setEpSquare(sq);
+        i += 2;
+    }
+    if (i < n && !isFenSpace(fen[i]))
+        return fail("malformed en-passant square");
+
+    // The move clocks are optional
+    while (i < n && isFenSpace(fen[i]))
+        ++i;
+    if (i < n) {
+        if (!parseClock(fen, i, m_halfmoveClock))
+            return fail("malformed halfmove clock");
+        while (i < n && isFenSpace(fen[i]))
+            ++i;
+        if (i < n) {
+            if (!parseClock(fen, i, m_fullmoveNumber))
+                return fail("malformed fullmove number");
+            if (m_fullmoveNumber == 0)
+                m_fullmoveNumber = 1;
+        }
+    }
+
+    while (i < n && isFenSpace(fen[i]))
+        ++i;
+    if (i < n)
+        return fail("unexpected characters after FEN");
+
+    return FenError{nullptr, i};
+}
+
+size_t Position::toFen(char* buf) const {
+    char* out = buf;
+
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            Piece pc = m_board[makeSquare(file, rank)];
+            if (pc == NO_PIECE) {
+                ++empty;
+                continue;
+            }
+            if (empty)
+                *out++ = static_cast<char>('0' + empty);
+            empty = 0;
+            *out++ = pieceLetters[pc];
+        }
+        if (empty)
+            *out++ = static_cast<char>('0' + empty);
+        if (rank)
+            *out++ = '/';
+    }
+
+    *out++ = ' ';
+    *out++ = m_sideToMove == WHITE ? 'w' : 'b';
+
+    *out++ = ' ';
+    if (m_castlingRights == NO_CASTLING)
+        *out++ = '-';
+    if (m_castlingRights & WHITE_OO)
+        *out++ = 'K';
+    if (m_castlingRights & WHITE_OOO)
+        *out++ = 'Q';
+    if (m_castlingRights & BLACK_OO)
+        *out++ = 'k';
+    if (m_castlingRights & BLACK_OOO)
+        *out++ = 'q';
+
+    *out++ = ' ';
+    if (m_epSquare == NO_SQUARE) {
+        *out++ = '-';
+    } else {
+        *out++ = static_cast<char>('a' + fileOf(m_epSquare));
+        *out++ = static_cast<char>('1' + rankOf(m_epSquare));
+    }
+
+    *out++ = ' ';
+    out = writeNumber(out, m_halfmoveClock);
+    *out++ = ' ';
+    out = writeNumber(out, m_fullmoveNumber);
+    *out = '\0';
+    return static_cast<size_t>(out - buf);
+}
+
+void Position::setSideToMove(Color c) {
+    if (c != m_sideToMove)
+        m_key ^= zobristSide;
+    m_sideToMove = c;
+}
+
+void Position::setCastlingRights(int rights) {
+    m_key ^= zobristCastling[m_castlingRights] ^ zobristCastling[rights];
+    m_castlingRights = static_cast<uint8_t>(rights);
+}
+
+void Position::setEpSquare(int sq) {
+    if (m_epSquare != NO_SQUARE)
+        m_key ^= zobristEpFile[fileOf(m_epSquare)];
+
+    // A square on rank 3 can only be taken by black pawns, one on rank 6 by white pawns
+    if (sq != NO_SQUARE) {
+        Color capturer = (rankOf(sq) == 2) ? BLACK : WHITE;
+        if (!(pawnAttacks(~capturer, sq) & m_pieces[capturer][PAWN]))
+            sq = NO_SQUARE;
+    }
+
+    m_epSquare = static_cast<uint8_t>(sq);
+    if (sq != NO_SQUARE)
+        m_key ^= zobristEpFile[fileOf(sq)];
+}
+
+uint64_t Position::computeKey() const {
+    uint64_t key = 0;
+    for (int sq = 0; sq < 64; ++sq)
+        if (m_board[sq] != NO_PIECE)
+            key ^= zobristPiece[m_board[sq]][sq];
+
+    key ^= zobristCastling[m_castlingRights];
+    if (m_epSquare != NO_SQUARE)
+        key ^= zobristEpFile[fileOf(m_epSquare)];
+    if (m_sideToMove == BLACK)
+        key ^= zobristSide;
+    return key;
+}
+
+void Position::putPiece(Piece pc, int sq) {
+    if (m_board[sq] != NO_PIECE)
+        removePiece(sq);
+
+    Bitboard b = squareBB(sq);
+    m_pieces[colorOf(pc)][typeOf(pc)] |= b;
+    m_colors[colorOf(pc)] |= b;
+    m_board[sq] = pc;
+    m_key ^= zobristPiece[pc][sq];
+    if (typeOf(pc) == PAWN)
+        m_pawnKey ^= zobristPiece[pc][sq];
+    m_psq += psqTable[pc][sq];
+    m_phase += phaseWeight[typeOf(pc)];
+    if (typeOf(pc) == KING)
+        m_kingSquare[colorOf(pc)] = static_cast<uint8_t>(sq);
+}
+
+void Position::removePiece(int sq) {
+    Piece pc = m_board[sq];
+    if (pc == NO_PIECE)
+        return;
+
+    Bitboard b = squareBB(sq);
+    m_pieces[colorOf(pc)][typeOf(pc)] &= ~b;
+    m_colors[colorOf(pc)] &= ~b;
+    m_board[sq] = NO_PIECE;
+    m_key ^= zobristPiece[pc][sq];
+    if (typeOf(pc) == PAWN)
+        m_pawnKey ^= zobristPiece[pc][sq];
+    m_psq -= psqTable[pc][sq];
+    m_phase -= phaseWeight[typeOf(pc)];
+    if (typeOf(pc) == KING)
+        m_kingSquare[colorOf(pc)] = NO_SQUARE;
+}
+
+void Position::movePiece(int from, int to) {
+    Piece pc = m_board[from];
+    if (pc == NO_PIECE)
+        return;
+
+    if (m_board[to] != NO_PIECE)
+        removePiece(to);
+
+    Bitboard fromTo = squareBB(from) | squareBB(to);
+    m_pieces[colorOf(pc)][typeOf(pc)] ^= fromTo;
+    m_colors[colorOf(pc)] ^= fromTo;
+    m_board[from] = NO_PIECE;
+    m_board[to] = pc;
+    m_key ^= zobristPiece[pc][from] ^ zobristPiece[pc][to];
+    if (typeOf(pc) == PAWN)
+        m_pawnKey ^= zobristPiece[pc][from] ^ zobristPiece[pc][to];
+    m_psq += psqTable[pc][to] - psqTable[pc][from];
+    if (typeOf(pc) == KING)
+        m_kingSquare[colorOf(pc)] = static_cast<uint8_t>(to);
+}
+
+Bitboard Position::attackersTo(int sq, Bitboard occupied) const {
+    Bitboard bishopsQueens = m_pieces[WHITE][BISHOP] | m_pieces[BLACK][BISHOP]
+                           | m_pieces[WHITE][QUEEN] | m_pieces[BLACK][QUEEN];
+    Bitboard rooksQueens = m_pieces[WHITE][ROOK] | m_pieces[BLACK][ROOK]
+                         | m_pieces[WHITE][QUEEN] | m_pieces[BLACK][QUEEN];
+
+    return (pawnAttacks(BLACK, sq) & m_pieces[WHITE][PAWN])
+         | (pawnAttacks(WHITE, sq) & m_pieces[BLACK][PAWN])
+         | (knightAttacks(sq) & (m_pieces[WHITE][KNIGHT] | m_pieces[BLACK][KNIGHT]))
+         | (kingAttacks(sq) & (m_pieces[WHITE][KING] | m_pieces[BLACK][KING]))
+         | (bishopAttacks(sq, occupied) & bishopsQueens)
+         | (rookAttacks(sq, occupied) & rooksQueens);
+}
+
+// Look outwards from the target square instead of generating every enemy move
+bool Position::isSquareAttacked(int sq, Color byColor) const {
+    Bitboard occ = occupied();
+    Bitboard queens = m_pieces[byColor][QUEEN];
+
+    return (pawnAttacks(~byColor, sq) & m_pieces[byColor][PAWN])
+        || (knightAttacks(sq) & m_pieces[byColor][KNIGHT])
+        || (kingAttacks(sq) & m_pieces[byColor][KING])
+        || (bishopAttacks(sq, occ) & (m_pieces[byColor][BISHOP] | queens))
+        || (rookAttacks(sq, occ) & (m_pieces[byColor][ROOK] | queens));
+}
+
+void Position::makeMove(Move m) {
+    UndoInfo undo;
+    makeMove(m, undo);
+}
+
+void Position::makeMove(Move m, UndoInfo& undo) {
+    Color us = m_sideToMove;
+    int from = m.from();
+    int to = m.to();
+    int flags = m.flags();
+    Piece pc = m_board[from];
+
+    undo.key = m_key;
+    undo.halfmoveClock = m_halfmoveClock;
+    undo.castlingRights = m_castlingRights;
+    undo.epSquare = m_epSquare;
+    undo.captured = (flags == EP_CAPTURE) ? makePiece(~us, PAWN) : m_board[to];
+
+    if (typeOf(pc) == PAWN || m.isCapture())
+        m_halfmoveClock = 0;
+    else
+        ++m_halfmoveClock;
+
+    if (flags == EP_CAPTURE)
+        removePiece(to + (us == WHITE ? -8 : 8));
+
+    movePiece(from, to);
+
+    if (m.isPromotion()) {
+        removePiece(to);
+        putPiece(makePiece(us, m.promotionType()), to);
+    }
+
+    // The king has already moved; bring the rook across it
+    if (flags == KING_CASTLE)
+        movePiece(to + 1, to - 1);
+    else if (flags == QUEEN_CASTLE)
+        movePiece(to - 2, to + 1);
+
+    int rights = m_castlingRights & ~(castlingRightsMask(from) | castlingRightsMask(to));
+    if (rights != m_castlingRights) {
+        m_key ^= zobristCastling[m_castlingRights] ^ zobristCastling[rights];
+        m_castlingRights = static_cast<uint8_t>(rights);
+    }
+
+    if (m_epSquare != NO_SQUARE) {
+        m_key ^= zobristEpFile[fileOf(m_epSquare)];
+        m_epSquare = NO_SQUARE;
+    }
+    if (flags == DOUBLE_PAWN_PUSH) {
+        int ep = (from + to) / 2;
+        if (pawnAttacks(us, ep) & m_pieces[~us][PAWN]) {
+            m_epSquare = static_cast<uint8_t>(ep);
+            m_key ^= zobristEpFile[fileOf(ep)];
+        }
+    }
+
+    if (us == BLACK)
+        ++m_fullmoveNumber;
+    m_sideToMove = ~us;
+    m_key ^= zobristSide;
+}
+
+// Restores the saved key at the end, so the board edits below skip hashing;
+// the pawn key and piece-square score have no saved copy and are updated as
+// pieces go back.
+void Position::unmakeMove(Move m, const UndoInfo& undo) {
+    Color us = ~m_sideToMove;
+    Color them = m_sideToMove;
+    int from = m.from();
+    int to = m.to();
+    int flags = m.flags();
+    PieceType pt = typeOf(m_board[to]);
+
+    if (m.isPromotion()) {
+        m_pieces[us][pt] ^= squareBB(to);
+        m_pieces[us][PAWN] ^= squareBB(to);
+        m_psq += psqTable[makePiece(us, PAWN)][to] - psqTable[m_board[to]][to];
+        m_phase -= phaseWeight[pt];
+        pt = PAWN;
+    }
+
+    Piece pc = makePiece(us, pt);
+    Bitboard fromTo = squareBB(from) | squareBB(to);
+    m_pieces[us][pt] ^= fromTo;
+    m_colors[us] ^= fromTo;
+    m_psq += psqTable[pc][from] - psqTable[pc][to];
+    if (pt == PAWN)
+        m_pawnKey ^= zobristPiece[pc][from] ^ (m.isPromotion() ? 0 : zobristPiece[pc][to]);
+    m_board[from] = pc;
+    m_board[to] = NO_PIECE;
+    if (pt == KING)
+        m_kingSquare[us] = static_cast<uint8_t>(from);
+
+    if (flags == KING_CASTLE || flags == QUEEN_CASTLE) {
+        int rookFrom = (flags == KING_CASTLE) ? to + 1 : to - 2;
+        int rookTo = (flags == KING_CASTLE) ? to - 1 : to + 1;
+        Bitboard rookMove = squareBB(rookFrom) | squareBB(rookTo);
+        m_pieces[us][ROOK] ^= rookMove;
+        m_colors[us] ^= rookMove;
+        m_psq += psqTable[m_board[rookTo]][rookFrom] - psqTable[m_board[rookTo]][rookTo];
+        m_board[rookFrom] = m_board[rookTo];
+        m_board[rookTo] = NO_PIECE;
+    }
+
+    if (undo.captured != NO_PIECE) {
+        int capSq = (flags == EP_CAPTURE) ? to + (us == WHITE ? -8 : 8) : to;
+        m_pieces[them][typeOf(undo.captured)] |= squareBB(capSq);
+        m_colors[them] |= squareBB(capSq);
+        m_psq += psqTable[undo.captured][capSq];
+        if (typeOf(undo.captured) == PAWN)
+            m_pawnKey ^= zobristPiece[undo.captured][capSq];
+        m_phase += phaseWeight[typeOf(undo.captured)];
+        m_board[capSq] = undo.captured;
+    }
+
+    if (us == BLACK)
+        --m_fullmoveNumber;
+    m_sideToMove = us;
+    m_castlingRights = undo.castlingRights;
+    m_epSquare = undo.epSquare;
+    m_halfmoveClock = undo.halfmoveClock;
+    m_key = undo.key;
+}
+
+void Position::makeNullMove(UndoInfo& undo) {
+    undo.key = m_key;
+    undo.halfmoveClock = m_halfmoveClock;
+    undo.castlingRights = m_castlingRights;
+    undo.epSquare = m_epSquare;
+    undo.captured = NO_PIECE;
+
+    if (m_epSquare != NO_SQUARE) {
+        m_key ^= zobristEpFile[fileOf(m_epSquare)];
+        m_epSquare = NO_SQUARE;
+    }
+    ++m_halfmoveClock;
+    m_sideToMove = ~m_sideToMove;
+    m_key ^= zobristSide;
+}
+
+void Position::unmakeNullMove(const UndoInfo& undo) {
+    m_sideToMove = ~m_sideToMove;
+    m_epSquare = undo.epSquare;
+    m_halfmoveClock = undo.halfmoveClock;
+    m_key = undo.key;
+}
@@ -0,0 +1,176 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+// Headless chess position: one bitboard per piece type and colour plus the
+// side to move, castling rights, en-passant square and move clocks.
+// Deliberately free of any Qt dependency so it can run in server processes.
+
+#include <cstddef>
+#include <string_view>
+#include "Bitboard.h"
+#include "Psqt.h"
+#include "Zobrist.h"
+
+enum Color : uint8_t { WHITE, BLACK, COLOR_NB };
+enum PieceType : uint8_t { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, PIECE_TYPE_NB, NO_PIECE_TYPE = PIECE_TYPE_NB };
+
+// Piece code = color * 6 + type, NO_PIECE for empty squares.
+typedef uint8_t Piece;
+const Piece NO_PIECE = 12;
+
+inline Piece makePiece(Color c, PieceType pt) { return static_cast<Piece>(c * 6 + pt); }
+inline Color colorOf(Piece pc) { return static_cast<Color>(pc / 6); }
+inline PieceType typeOf(Piece pc) { return static_cast<PieceType>(pc % 6); }
+inline Color operator~(Color c) { return static_cast<Color>(c ^ 1); }
+
+enum CastlingRights : uint8_t {
+    NO_CASTLING = 0,
+    WHITE_OO = 1,
+    WHITE_OOO = 2,
+    BLACK_OO = 4,
+    BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+// Castling rights lost when a move starts or ends on sq (king or rook squares).
+inline int castlingRightsMask(int sq) {
+    switch (sq) {
+    case 0:  return WHITE_OOO;
+    case 4:  return WHITE_OO | WHITE_OOO;
+    case 7:  return WHITE_OO;
+    case 56: return BLACK_OOO;
+    case 60: return BLACK_OO | BLACK_OOO;
+    case 63: return BLACK_OO;
+    default: return NO_CASTLING;
+    }
+}
+
+class Move;
+
+// Outcome of FEN parsing. message is null on success; otherwise it is a
+// static description and offset is the byte of the FEN where parsing stopped.
+struct FenError {
+    const char* message;
+    size_t offset;
+
+    bool ok() const { return message == nullptr; }
+};
+
+// Buffer size toFen needs for any position, terminator included
+const size_t MAX_FEN_LENGTH = 96;
+
+// Everything makeMove overwrites that unmakeMove cannot work out from the move.
+struct UndoInfo {
+    uint64_t key;
+    uint16_t halfmoveClock;
+    uint8_t castlingRights;
+    uint8_t epSquare;
+    Piece captured;
+};
+
+class Position {
+public:
+    Position();
+
+    void clear();
+    void setStartPosition();
+
+    // Load a position from Forsyth-Edwards Notation, rejecting malformed and
+    // impossible positions (missing kings, side not to move in check, castling
+    // rights without their rook, more material than promotions allow, ...). The move clocks may be left out and
+    // surrounding whitespace is ignored. Never allocates; on error the
+    // position is left cleared.
+    FenError fromFen(std::string_view fen);
+    bool setFromFen(const char* fen) { return fromFen(fen).ok(); }
+
+    // Whether each side's material could come from a game: at most 16
+    // pieces and 8 pawns, and no more queens, rooks, bishops and knights
+    // beyond the starting set than pawns missing to promote. MAX_MOVES only
+    // bounds positions that pass this.
+    bool hasReachableMaterial() const;
+
+    // Write the position as a NUL-terminated FEN into buf, which must hold
+    // MAX_FEN_LENGTH bytes; returns the length.
+    size_t toFen(char* buf) const;
+
+    // Low-level board edits; they keep every bitboard, the mailbox, the hash
+    // key and the piece-square score in sync but do not touch side to move, castling rights or clocks.
+    void putPiece(Piece pc, int sq);
+    void removePiece(int sq);
+    void movePiece(int from, int to);
+
+    Bitboard pieces(Color c, PieceType pt) const { return m_pieces[c][pt]; }
+    Bitboard pieces(Color c) const { return m_colors[c]; }
+    Bitboard occupied() const { return m_colors[WHITE] | m_colors[BLACK]; }
+    Piece pieceOn(int sq) const { return m_board[sq]; }
+    bool isEmpty(int sq) const { return m_board[sq] == NO_PIECE; }
+
+    Color sideToMove() const { return m_sideToMove; }
+    void setSideToMove(Color c);
+
+    int castlingRights() const { return m_castlingRights; }
+    void setCastlingRights(int rights);
+
+    // Only kept when a pawn can actually capture there, so positions that
+    // differ only by a dead en-passant square share a key.
+    int epSquare() const { return m_epSquare; }
+    void setEpSquare(int sq);
+
+    int halfmoveClock() const { return m_halfmoveClock; }
+    void setHalfmoveClock(int clock) { m_halfmoveClock = static_cast<uint16_t>(clock); }
+
+    int fullmoveNumber() const { return m_fullmoveNumber; }
+    void setFullmoveNumber(int number) { m_fullmoveNumber = static_cast<uint16_t>(number); }
+
+    // Maintained incrementally by the board edits; NO_SQUARE while a king is missing.
+    int kingSquare(Color c) const { return m_kingSquare[c]; }
+
+    // Reverse attack lookup: every piece of either colour attacking sq.
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+    bool isSquareAttacked(int sq, Color byColor) const;
+    Bitboard checkers() const { return attackersTo(m_kingSquare[m_sideToMove], occupied()) & m_colors[~m_sideToMove]; }
+    bool inCheck() const { return isSquareAttacked(m_kingSquare[m_sideToMove], ~m_sideToMove); }
+
+    // Apply a move produced by the move generator for this position. The
+    // two-argument form records what unmakeMove needs to take it back.
+    void makeMove(Move m);
+    void makeMove(Move m, UndoInfo& undo);
+    void unmakeMove(Move m, const UndoInfo& undo);
+
+    // Pass the turn without moving, for null-move pruning. Not legal in check.
+    void makeNullMove(UndoInfo& undo);
+    void unmakeNullMove(const UndoInfo& undo);
+
+    // Zobrist key of pieces, side to move, castling rights and en-passant file,
+    // updated incrementally by every edit.
+    uint64_t key() const { return m_key; }
+    uint64_t computeKey() const;
+
+    // Key of the pawns alone, for caching pawn-structure evaluation; zero
+    // when neither side has pawns.
+    uint64_t pawnKey() const { return m_pawnKey; }
+
+    // Material and piece-square score from White's point of view, and the
+    // game phase from PHASE_MAX (all pieces) down to 0 (pawns and kings).
+    // Both are updated incrementally by every edit and by unmakeMove.
+    Score psqScore() const { return m_psq; }
+    int gamePhase() const { return m_phase < PHASE_MAX ? m_phase : PHASE_MAX; }
+
+private:
+    Bitboard m_pieces[COLOR_NB][PIECE_TYPE_NB];
+    Bitboard m_colors[COLOR_NB];
+    Piece m_board[64];
+    uint8_t m_kingSquare[COLOR_NB];
+
+    Color m_sideToMove;
+    uint8_t m_castlingRights;
+    uint8_t m_epSquare;
+    uint16_t m_halfmoveClock;
+    uint16_t m_fullmoveNumber;
+    uint64_t m_key;
+    uint64_t m_pawnKey;
+    Score m_psq;
+    int m_phase;   // may exceed PHASE_MAX after promotions
+};
+
+#endif // POSITION_H
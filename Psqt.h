@@ -0,0 +1,33 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+// Material plus piece-square bonuses, kept incrementally by Position.
+//
+// A Score packs a middlegame and an endgame value into one integer, so both
+// halves are updated with a single addition. Tables are from White's point
+// of view: black pieces hold the negated, rank-mirrored white values.
+
+#include <cstdint>
+
+typedef int32_t Score;
+
+inline Score makeScore(int mg, int eg) {
+    return static_cast<Score>(static_cast<uint32_t>(eg) << 16) + mg;
+}
+
+// The low half is signed, so round the high half before taking it
+inline int egValue(Score s) {
+    return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(s + 0x8000) >> 16));
+}
+
+inline int mgValue(Score s) {
+    return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(s)));
+}
+
+extern Score psqTable[12][64];
+
+// Game phase contributed by each piece type; the opening total is PHASE_MAX
+extern const int phaseWeight[6];
+const int PHASE_MAX = 24;
+
+#endif // PSQT_H
@@ -0,0 +1,182 @@
+#include "San.h"
+#include "Attacks.h"
+#include "MoveGen.h"
+
+namespace {
+
+const char pieceSanLetters[] = "PNBRQK";
+
+PieceType sanPieceType(char c) {
+    switch (c) {
+    case 'N': return KNIGHT;
+    case 'B': return BISHOP;
+    case 'R': return ROOK;
+    case 'Q': return QUEEN;
+    case 'K': return KING;
+    default: return NO_PIECE_TYPE;
+    }
+}
+
+bool isSanSuffix(char c) {
+    return c == '+' || c == '#' || c == '!' || c == '?';
+}
+
+// Squares from which a piece of type pt of the side to move could go to
+// `to`, before checking that the move leaves its king safe
+Bitboard originCandidates(const Position& pos, PieceType pt, int to) {
+    Color us = pos.sideToMove();
+    if (pos.pieces(us) & squareBB(to))
+        return 0;
+    if (pt != PAWN)
+        return attacksFrom(pt, to, pos.occupied()) & pos.pieces(us, pt);
+
+    Bitboard pawns = pos.pieces(us, PAWN);
+    if (!pos.isEmpty(to) || to == pos.epSquare())
+        return pawnAttacks(~us, to) & pawns;
+
+    int forward = us == WHITE ? 8 : -8;
+    int one = to - forward;
+    if (one < 0 || one > 63)
+        return 0;
+    if (pawns & squareBB(one))
+        return squareBB(one);
+    if (pos.isEmpty(one) && rankOf(to) == (us == WHITE ? 3 : 4))
+        return pawns & squareBB(one - forward);
+    return 0;
+}
+
+} // namespace
+
+Move parseSan(const Position& pos, std::string_view san) {
+    while (!san.empty() && isSanSuffix(san.back()))
+        san.remove_suffix(1);
+
+    // Castling is rare enough to look up among all legal moves
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        MoveList moves;
+        generateLegalMoves(pos, moves);
+        int flag = san.size() == 3 ? KING_CASTLE : QUEEN_CASTLE;
+        for (Move m : moves)
+            if (m.flags() == flag)
+                return m;
+        return Move();
+    }
+
+    size_t i = 0;
+    PieceType pt = san.empty() ? NO_PIECE_TYPE : sanPieceType(san[0]);
+    if (pt != NO_PIECE_TYPE)
+        i = 1;
+    else
+        pt = PAWN;
+
+    PieceType promotion = NO_PIECE_TYPE;
+    if (pt == PAWN && san.size() > 2) {
+        promotion = sanPieceType(san.back());
+        if (promotion == KING)
+            return Move();
+        if (promotion != NO_PIECE_TYPE) {
+            san.remove_suffix(1);
+            if (san.back() == '=')
+                san.remove_suffix(1);
+        }
+    }
+
+    if (san.size() < i + 2)
+        return Move();
+    char toFile = san[san.size() - 2];
+    char toRank = san[san.size() - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8')
+        return Move();
+    int to = makeSquare(toFile - 'a', toRank - '1');
+    san.remove_suffix(2);
+
+    // Disambiguation and the capture mark. A pawn named without a file
+    // pushes, so "e4" never means a capture onto e4.
+    int fromFile = pt == PAWN ? toFile - 'a' : -1;
+    int fromRank = -1;
+    for (; i < san.size(); ++i) {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h')
+            fromFile = c - 'a';
+        else if (c >= '1' && c <= '8')
+            fromRank = c - '1';
+        else if (c != 'x' || i + 1 != san.size())
+            return Move();
+    }
+
+    if (pt == PAWN && (rankOf(to) == 0 || rankOf(to) == 7) != (promotion != NO_PIECE_TYPE))
+        return Move();
+
+    Bitboard origins = originCandidates(pos, pt, to);
+    if (fromFile >= 0)
+        origins &= fileBB(fromFile);
+    if (fromRank >= 0)
+        origins &= rankBB(fromRank);
+
+    Move found;
+    int matches = 0;
+    while (origins) {
+        Move m = makeMoveTo(pos, popLsb(origins), to, promotion);
+        if (leavesKingSafe(pos, m)) {
+            found = m;
+            ++matches;
+        }
+    }
+    return matches == 1 ? found : Move();
+}
+
+size_t moveToSan(const Position& pos, Move m, char* out) {
+    char* p = out;
+
+    if (m.isCastle()) {
+        const char* castle = m.flags() == KING_CASTLE ? "O-O" : "O-O-O";
+        while (*castle)
+            *p++ = *castle++;
+    } else {
+        PieceType pt = typeOf(pos.pieceOn(m.from()));
+        if (pt == PAWN) {
+            if (m.isCapture())
+                *p++ = static_cast<char>('a' + fileOf(m.from()));
+        } else {
+            *p++ = pieceSanLetters[pt];
+
+            // Name the file, else the rank, else both, of the moving piece
+            // when another piece of its type can go to the same square
+            Bitboard others = originCandidates(pos, pt, m.to()) & ~squareBB(m.from());
+            bool ambiguous = false;
+            bool sameFile = false;
+            bool sameRank = false;
+            while (others) {
+                int from = popLsb(others);
+                if (!leavesKingSafe(pos, makeMoveTo(pos, from, m.to(), NO_PIECE_TYPE)))
+                    continue;
+                ambiguous = true;
+                sameFile |= fileOf(from) == fileOf(m.from());
+                sameRank |= rankOf(from) == rankOf(m.from());
+            }
+            if (ambiguous && (!sameFile || sameRank))
+                *p++ = static_cast<char>('a' + fileOf(m.from()));
+            if (ambiguous && sameFile)
+                *p++ = static_cast<char>('1' + rankOf(m.from()));
+        }
+
+        if (m.isCapture())
+            *p++ = 'x';
+        *p++ = static_cast<char>('a' + fileOf(m.to()));
+        *p++ = static_cast<char>('1' + rankOf(m.to()));
+        if (m.isPromotion()) {
+            *p++ = '=';
+            *p++ = pieceSanLetters[m.promotionType()];
+        }
+    }
+
+    Position next = pos;
+    next.makeMove(m);
+    if (next.inCheck()) {
+        MoveList replies;
+        generateLegalMoves(next, replies);
+        *p++ = replies.isEmpty() ? '#' : '+';
+    }
+    *p = '\0';
+    return static_cast<size_t>(p - out);
+}
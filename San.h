@@ -0,0 +1,25 @@
+#ifndef SAN_H
+#define SAN_H
+
+// Standard Algebraic Notation ("Nf3", "exd8=Q+", "O-O") for moves of a
+// given position, as used in PGN movetext.
+
+#include <cstddef>
+#include <string_view>
+#include "Move.h"
+#include "Position.h"
+
+// Longest SAN a move can take ("Qa1xb2#", "exd8=Q#"), terminator included
+const size_t MAX_SAN_LENGTH = 8;
+
+// The legal move of pos written as san, or a null move if san is malformed,
+// illegal or ambiguous. Check, mate and annotation suffixes ("+", "#", "!?")
+// are ignored, as are "0-0" style castles and a promotion without '='.
+Move parseSan(const Position& pos, std::string_view san);
+
+// Write the legal move m of pos as NUL-terminated SAN into out, which must
+// hold MAX_SAN_LENGTH bytes, with the shortest disambiguation and a check
+// or mate suffix; returns the length.
+size_t moveToSan(const Position& pos, Move m, char* out);
+
+#endif // SAN_H
@@ -0,0 +1,699 @@
+#include "Search.h"
+#include "Book.h"
+#include "Draw.h"
+#include "Evaluate.h"
+#include "MoveGen.h"
+#include "Tablebases.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Move ordering bands; within a band higher scores are tried first
+const int HASH_MOVE_SCORE = 1 << 30;
+const int CAPTURE_SCORE = 1 << 28;
+const int KILLER_SCORE = 1 << 27;
+const int UNDERPROMOTION_SCORE = -(1 << 29);
+
+// History scores saturate towards this bound instead of growing without limit
+const int HISTORY_MAX = 16384;
+
+const int ASPIRATION_DELTA = 25;
+
+// Mate and tablebase scores are stored relative to the node rather than
+// the root so an entry stays correct at whatever ply it is found again.
+int scoreToTT(int score, int ply) {
+    if (score >= VALUE_TB_WIN_IN_MAX_PLY)
+        return score + ply;
+    if (score <= -VALUE_TB_WIN_IN_MAX_PLY)
+        return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score >= VALUE_TB_WIN_IN_MAX_PLY)
+        return score - ply;
+    if (score <= -VALUE_TB_WIN_IN_MAX_PLY)
+        return score + ply;
+    return score;
+}
+
+// Selection sort step: bring the best remaining move to index i
+void pickNext(MoveList& moves, int* scores, int i) {
+    int best = i;
+    for (int j = i + 1; j < moves.size(); ++j)
+        if (scores[j] > scores[best])
+            best = j;
+    if (best != i) {
+        std::swap(moves[i], moves[best]);
+        std::swap(scores[i], scores[best]);
+    }
+}
+
+// Zugzwang is common with only king and pawns, so null moves are not tried there
+bool hasNonPawnMaterial(const Position& pos, Color c) {
+    return (pos.pieces(c) & ~pos.pieces(c, PAWN) & ~pos.pieces(c, KING)) != 0;
+}
+
+// Lazy SMP depth perturbation: helper i skips iterations in blocks of
+// SKIP_SIZE[i] shifted by SKIP_PHASE[i], so the helpers spread over
+// different depths instead of all repeating the main thread's work.
+const int SKIP_PATTERNS = 20;
+const int SKIP_SIZE[SKIP_PATTERNS] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const int SKIP_PHASE[SKIP_PATTERNS] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+} // namespace
+
+// One search thread: its own position, stack and ordering statistics.
+// Everything else is shared through the transposition table.
+class SearchWorker {
+public:
+    SearchWorker(Search& search, int id);
+
+    void clear();
+    void prepare(const Position& root, const std::vector<uint64_t>& history);
+
+    // Iterative deepening up to maxDepth. Only the main worker fills result,
+    // reports progress and applies the soft time limit.
+    void iterate(int maxDepth, SearchResult& result);
+
+    uint64_t nodes() const { return m_nodes.load(std::memory_order_relaxed); }
+    uint64_t tbHits() const { return m_tbHits.load(std::memory_order_relaxed); }
+    PawnTable& pawnTable() { return m_pawns; }
+    const PawnTable& pawnTable() const { return m_pawns; }
+
+private:
+    struct Stack {
+        Move pv[MAX_PLY + 1];
+        int pvLength;
+        Move killers[2];
+        Move currentMove;   // null after a null move
+    };
+
+    int negamax(Position& pos, int alpha, int beta, int depth, int ply);
+    int quiescence(Position& pos, int alpha, int beta, int ply);
+
+    void scoreMoves(const Position& pos, const MoveList& moves, int* scores, Move hashMove, int ply) const;
+    bool isRepetition(const Position& pos) const;
+    void updatePv(int ply, Move m);
+    void updateQuietStats(const Position& pos, Move m, int depth, int ply, const Move* tried, int triedCount);
+
+    bool stopped() const { return m_search.m_stop.load(std::memory_order_relaxed); }
+    bool countNodeAndCheckStop();
+    bool probeTablebases(const Position& pos, int alpha, int beta, int depth, int ply, int& score);
+
+    Search& m_search;
+    TranspositionTable& m_tt;
+    int m_id;
+
+    Position m_root;
+    // Only this worker writes its count; others read it for reporting
+    std::atomic<uint64_t> m_nodes;
+    std::atomic<uint64_t> m_tbHits;
+    int m_selDepth;
+    Stack m_stack[MAX_PLY + 1];
+    int m_history[COLOR_NB][64][64];
+    PawnTable m_pawns;
+
+    // Keys of the game before root followed by the current search path
+    std::vector<uint64_t> m_keys;
+};
+
+SearchWorker::SearchWorker(Search& search, int id)
+    : m_search(search), m_tt(search.m_tt), m_id(id), m_nodes(0), m_tbHits(0), m_selDepth(0),
+      m_pawns(search.m_pawnHashKb) {
+    m_keys.reserve(1024 + MAX_PLY);
+    clear();
+}
+
+void SearchWorker::clear() {
+    for (int c = 0; c < COLOR_NB; ++c)
+        for (int from = 0; from < 64; ++from)
+            for (int to = 0; to < 64; ++to)
+                m_history[c][from][to] = 0;
+
+    for (Stack& ss : m_stack) {
+        ss.killers[0] = ss.killers[1] = Move();
+        ss.currentMove = Move();
+        ss.pvLength = 0;
+    }
+    m_pawns.clear();
+}
+
+void SearchWorker::prepare(const Position& root, const std::vector<uint64_t>& history) {
+    m_root = root;
+    m_nodes.store(0, std::memory_order_relaxed);
+    m_tbHits.store(0, std::memory_order_relaxed);
+    m_pawns.resetStats();
+    m_selDepth = 0;
+    m_keys.assign(history.begin(), history.end());
+    m_keys.push_back(root.key());
+    for (Stack& ss : m_stack)
+        ss.killers[0] = ss.killers[1] = Move();
+}
+
+// Helpers only watch the stop flag; the main worker also polls the budget
+bool SearchWorker::countNodeAndCheckStop() {
+    uint64_t n = m_nodes.load(std::memory_order_relaxed) + 1;
+    m_nodes.store(n, std::memory_order_relaxed);
+    if (stopped())
+        return true;
+    return m_id == 0 && (n & 255) == 0 && m_search.checkLimits();
+}
+
+// Only positions since the last capture or pawn move can repeat, and only
+// with the same side to move.
+bool SearchWorker::isRepetition(const Position& pos) const {
+    int last = static_cast<int>(m_keys.size()) - 1;
+    int reach = std::min(static_cast<int>(pos.halfmoveClock()), last);
+    for (int back = 4; back <= reach; back += 2)
+        if (m_keys[last - back] == pos.key())
+            return true;
+    return false;
+}
+
+// Score a position reached by a capture or pawn move from the tablebases;
+// earlier positions would repeat the probe with nothing new to learn. A win
+// is only a lower bound, so a shorter mate can still be found below it.
+bool SearchWorker::probeTablebases(const Position& pos, int alpha, int beta, int depth, int ply, int& score) {
+    const Tablebases* tablebases = m_search.m_tablebases;
+    WdlScore wdl;
+    if (pos.halfmoveClock() != 0 || popCount(pos.occupied()) > m_search.m_tbPieces
+        || !tablebases->probeWdl(pos, wdl))
+        return false;
+    m_tbHits.store(m_tbHits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // Cursed wins and blessed losses are draws under the fifty-move rule
+    Bound bound;
+    if (wdl == WDL_WIN) {
+        score = VALUE_TB_WIN - ply;
+        bound = BOUND_LOWER;
+    } else if (wdl == WDL_LOSS) {
+        score = -VALUE_TB_WIN + ply;
+        bound = BOUND_UPPER;
+    } else {
+        score = VALUE_DRAW + wdl;
+        bound = BOUND_EXACT;
+    }
+    if (bound == BOUND_EXACT || (bound == BOUND_LOWER && score >= beta) || (bound == BOUND_UPPER && score <= alpha)) {
+        m_tt.store(pos.key(), std::min(depth + 6, MAX_PLY - 1), bound, scoreToTT(score, ply), Move(), VALUE_DRAW);
+        return true;
+    }
+    return false;
+}
+
+void SearchWorker::updatePv(int ply, Move m) {
+    Stack& ss = m_stack[ply];
+    const Stack& child = m_stack[ply + 1];
+    ss.pv[0] = m;
+    for (int i = 0; i < child.pvLength; ++i)
+        ss.pv[i + 1] = child.pv[i];
+    ss.pvLength = child.pvLength + 1;
+}
+
+void SearchWorker::updateQuietStats(const Position& pos, Move m, int depth, int ply,
+                              const Move* tried, int triedCount) {
+    Stack& ss = m_stack[ply];
+    if (ss.killers[0] != m) {
+        ss.killers[1] = ss.killers[0];
+        ss.killers[0] = m;
+    }
+
+    // Reward the cutoff move and penalise the quiet moves tried before it
+    Color us = pos.sideToMove();
+    int bonus = std::min(depth * depth, 400);
+    int& best = m_history[us][m.from()][m.to()];
+    best += bonus - best * bonus / HISTORY_MAX;
+    for (int i = 0; i < triedCount; ++i) {
+        int& h = m_history[us][tried[i].from()][tried[i].to()];
+        h -= bonus + h * bonus / HISTORY_MAX;
+    }
+}
+
+void SearchWorker::scoreMoves(const Position& pos, const MoveList& moves, int* scores, Move hashMove, int ply) const {
+    const Stack& ss = m_stack[ply];
+    Color us = pos.sideToMove();
+
+    for (int i = 0; i < moves.size(); ++i) {
+        Move m = moves[i];
+        if (m == hashMove) {
+            scores[i] = HASH_MOVE_SCORE;
+        } else if (m.isPromotion() && m.promotionType() != QUEEN) {
+            scores[i] = UNDERPROMOTION_SCORE;
+        } else if (m.isCapture() || m.isPromotion()) {
+            // Most valuable victim first, least valuable attacker breaks ties
+            int victim = m.isEnPassant() ? PAWN + 1 : (m.isCapture() ? typeOf(pos.pieceOn(m.to())) + 1 : 0);
+            int attacker = typeOf(pos.pieceOn(m.from()));
+            scores[i] = CAPTURE_SCORE + 16 * victim - attacker + (m.isPromotion() ? 16 * QUEEN : 0);
+        } else if (m == ss.killers[0]) {
+            scores[i] = KILLER_SCORE + 1;
+        } else if (m == ss.killers[1]) {
+            scores[i] = KILLER_SCORE;
+        } else {
+            scores[i] = m_history[us][m.from()][m.to()];
+        }
+    }
+}
+
+int SearchWorker::negamax(Position& pos, int alpha, int beta, int depth, int ply) {
+    if (depth <= 0)
+        return quiescence(pos, alpha, beta, ply);
+
+    m_stack[ply].pvLength = 0;
+    if (countNodeAndCheckStop())
+        return 0;
+    m_selDepth = std::max(m_selDepth, ply);
+
+    bool pvNode = beta - alpha > 1;
+    bool rootNode = ply == 0;
+
+    if (!rootNode) {
+        if (pos.halfmoveClock() >= 100 || isRepetition(pos) || isInsufficientMaterial(pos))
+            return VALUE_DRAW;
+        if (ply >= MAX_PLY)
+            return evaluate(pos, m_pawns);
+
+        // No line from here can beat a mate already found nearer the root
+        alpha = std::max(alpha, -VALUE_MATE + ply);
+        beta = std::min(beta, VALUE_MATE - ply - 1);
+        if (alpha >= beta)
+            return alpha;
+    }
+
+    uint64_t key = pos.key();
+    TTData tte;
+    Move hashMove;
+    if (m_tt.probe(key, tte)) {
+        hashMove = tte.move;
+        int ttScore = scoreFromTT(tte.score, ply);
+        if (!pvNode && tte.depth >= depth
+            && (tte.bound == BOUND_EXACT
+                || (tte.bound == BOUND_LOWER && ttScore >= beta)
+                || (tte.bound == BOUND_UPPER && ttScore <= alpha)))
+            return ttScore;
+    }
+
+    if (!rootNode && m_search.m_tablebases) {
+        int tbScore;
+        if (probeTablebases(pos, alpha, beta, depth, ply, tbScore))
+            return tbScore;
+    }
+
+    bool inCheck = pos.inCheck();
+    int staticEval = evaluate(pos, m_pawns);
+    UndoInfo undo;
+
+    // Null move: if passing still fails high, a real move almost surely would
+    if (!pvNode && !rootNode && !inCheck && depth >= 3 && staticEval >= beta
+        && !m_stack[ply - 1].currentMove.isNull() && hasNonPawnMaterial(pos, pos.sideToMove())) {
+        int reduction = 3 + depth / 4;
+        m_stack[ply].currentMove = Move();
+        pos.makeNullMove(undo);
+        m_keys.push_back(pos.key());
+        int score = -negamax(pos, -beta, -beta + 1, depth - 1 - reduction, ply + 1);
+        m_keys.pop_back();
+        pos.unmakeNullMove(undo);
+
+        if (stopped())
+            return 0;
+        if (score >= beta)
+            return score >= VALUE_TB_WIN_IN_MAX_PLY ? beta : score;
+    }
+
+    MoveList moves;
+    if (rootNode)
+        moves = m_search.m_rootMoves;
+    else
+        generateLegalMoves(pos, moves);
+    if (moves.isEmpty())
+        return inCheck ? -VALUE_MATE + ply : VALUE_DRAW;
+
+    int scores[MAX_MOVES];
+    scoreMoves(pos, moves, scores, hashMove, ply);
+
+    int originalAlpha = alpha;
+    int bestScore = -VALUE_INFINITE;
+    Move bestMove;
+    Move quietsTried[64];
+    int quietCount = 0;
+
+    for (int i = 0; i < moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        Move m = moves[i];
+        bool quiet = !m.isCapture() && !m.isPromotion();
+
+        m_stack[ply].currentMove = m;
+        pos.makeMove(m, undo);
+        m_keys.push_back(pos.key());
+
+        // Checks are extended so forcing lines are not cut off at the horizon
+        bool givesCheck = pos.inCheck();
+        int newDepth = depth - 1 + (givesCheck ? 1 : 0);
+
+        int score;
+        if (i == 0) {
+            score = -negamax(pos, -beta, -alpha, newDepth, ply + 1);
+        } else {
+            // Late quiet moves are searched shallower first and re-searched if they surprise
+            int reduction = 0;
+            if (depth >= 3 && i >= 3 && quiet && !inCheck && !givesCheck && scores[i] < KILLER_SCORE)
+                reduction = (i >= 6 && depth >= 6) ? 2 : 1;
+
+            score = -negamax(pos, -alpha - 1, -alpha, newDepth - reduction, ply + 1);
+            if (reduction && score > alpha)
+                score = -negamax(pos, -alpha - 1, -alpha, newDepth, ply + 1);
+            if (score > alpha && score < beta)
+                score = -negamax(pos, -beta, -alpha, newDepth, ply + 1);
+        }
+
+        m_keys.pop_back();
+        pos.unmakeMove(m, undo);
+
+        if (stopped())
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                bestMove = m;
+                alpha = score;
+                if (pvNode)
+                    updatePv(ply, m);
+                if (score >= beta) {
+                    if (quiet)
+                        updateQuietStats(pos, m, depth, ply, quietsTried, quietCount);
+                    break;
+                }
+            }
+        }
+
+        if (quiet && quietCount < 64)
+            quietsTried[quietCount++] = m;
+    }
+
+    Bound bound = bestScore >= beta ? BOUND_LOWER
+                : bestScore > originalAlpha ? BOUND_EXACT
+                : BOUND_UPPER;
+    m_tt.store(key, depth, bound, scoreToTT(bestScore, ply), bestMove, staticEval);
+    return bestScore;
+}
+
+// Resolve captures until the position is quiet so the static evaluation is
+// not taken in the middle of an exchange. In check every evasion is tried.
+int SearchWorker::quiescence(Position& pos, int alpha, int beta, int ply) {
+    m_stack[ply].pvLength = 0;
+    if (countNodeAndCheckStop())
+        return 0;
+    m_selDepth = std::max(m_selDepth, ply);
+
+    // A capture can leave too little material to mate
+    if (isInsufficientMaterial(pos))
+        return VALUE_DRAW;
+    if (ply >= MAX_PLY)
+        return evaluate(pos, m_pawns);
+
+    bool inCheck = pos.inCheck();
+    int bestScore = -VALUE_INFINITE;
+    MoveList moves;
+
+    if (inCheck) {
+        generateLegalMoves(pos, moves);
+        if (moves.isEmpty())
+            return -VALUE_MATE + ply;
+    } else {
+        // Standing pat: the side to move need not capture
+        bestScore = evaluate(pos, m_pawns);
+        if (bestScore >= beta)
+            return bestScore;
+        alpha = std::max(alpha, bestScore);
+        generateLegalCaptures(pos, moves);
+    }
+
+    int scores[MAX_MOVES];
+    scoreMoves(pos, moves, scores, Move(), ply);
+
+    UndoInfo undo;
+    for (int i = 0; i < moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        Move m = moves[i];
+        if (!inCheck && m.isPromotion() && m.promotionType() != QUEEN)
+            continue;
+
+        pos.makeMove(m, undo);
+        int score = -quiescence(pos, -beta, -alpha, ply + 1);
+        pos.unmakeMove(m, undo);
+
+        if (stopped())
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (score >= beta)
+                    break;
+            }
+        }
+    }
+    return bestScore;
+}
+
+void SearchWorker::iterate(int maxDepth, SearchResult& result) {
+    Position pos = m_root;
+    bool mainWorker = m_id == 0;
+    int score = 0;
+    bool haveScore = false;
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        if (!mainWorker) {
+            int pattern = (m_id - 1) % SKIP_PATTERNS;
+            if (((depth + SKIP_PHASE[pattern]) / SKIP_SIZE[pattern]) % 2)
+                continue;
+        }
+
+        // Once a score is known, search a window around it and widen on failure
+        int delta = ASPIRATION_DELTA;
+        int alpha = -VALUE_INFINITE;
+        int beta = VALUE_INFINITE;
+        if (haveScore && depth >= 5) {
+            alpha = std::max(score - delta, -VALUE_INFINITE);
+            beta = std::min(score + delta, VALUE_INFINITE);
+        }
+
+        while (true) {
+            score = negamax(pos, alpha, beta, depth, 0);
+            if (stopped())
+                break;
+
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -VALUE_INFINITE);
+            } else if (score >= beta) {
+                beta = std::min(score + delta, VALUE_INFINITE);
+            } else {
+                break;
+            }
+            delta += delta / 2;
+        }
+
+        if (stopped()) {
+            // A move that raised alpha in the unfinished iteration is still fully searched
+            if (mainWorker && result.depth == 0 && m_stack[0].pvLength > 0)
+                result.bestMove = m_stack[0].pv[0];
+            break;
+        }
+        haveScore = true;
+
+        if (!mainWorker)
+            continue;
+
+        const Stack& rootStack = m_stack[0];
+        result.pv.assign(rootStack.pv, rootStack.pv + rootStack.pvLength);
+        result.bestMove = rootStack.pv[0];
+        result.ponderMove = rootStack.pvLength > 1 ? rootStack.pv[1] : Move();
+        result.score = score;
+        result.depth = depth;
+
+        if (m_search.m_onInfo) {
+            SearchInfo info = {depth, m_selDepth, score, m_search.nodesSearched(), m_search.tbHits(),
+                               m_search.elapsedMs(), result.pv};
+            m_search.m_onInfo(info);
+        }
+
+        // An iteration takes longer than all before it; do not start one that cannot finish
+        if (m_search.m_softLimitMs && m_search.elapsedMs() >= m_search.m_softLimitMs / 2)
+            break;
+        if (m_search.m_nodeLimit && m_search.nodesSearched() >= m_search.m_nodeLimit)
+            break;
+    }
+}
+
+Search::Search(TranspositionTable& tt, int threads)
+    : m_tt(tt), m_stop(false), m_stopRequests(0), m_softLimitMs(0), m_hardLimitMs(0), m_nodeLimit(0),
+      m_pawnHashKb(DEFAULT_PAWN_HASH_KB), m_book(nullptr), m_bookBestOnly(false),
+      m_bookRandom(std::random_device()()), m_tablebases(nullptr), m_tbPieces(0) {
+    setThreads(threads);
+}
+
+// Out of line so the worker type is complete where it is destroyed
+Search::~Search() = default;
+
+void Search::setThreads(int threads) {
+    if (threads < 1)
+        threads = 1;
+
+    m_pool.reset();
+    m_workers.clear();
+    for (int i = 0; i < threads; ++i)
+        m_workers.emplace_back(new SearchWorker(*this, i));
+
+    // The pool counts the calling thread, which runs the main worker itself
+    if (threads > 1)
+        m_pool.reset(new ThreadPool(threads));
+}
+
+void Search::clear() {
+    for (auto& worker : m_workers)
+        worker->clear();
+}
+
+void Search::setPawnHashSize(size_t kilobytes) {
+    m_pawnHashKb = kilobytes;
+    for (auto& worker : m_workers)
+        worker->pawnTable().resize(kilobytes);
+}
+
+PawnTableStats Search::pawnHashStats() const {
+    PawnTableStats total = {0, 0};
+    for (const auto& worker : m_workers) {
+        PawnTableStats s = worker->pawnTable().stats();
+        total.hits += s.hits;
+        total.misses += s.misses;
+    }
+    return total;
+}
+
+uint64_t Search::nodesSearched() const {
+    uint64_t total = 0;
+    for (const auto& worker : m_workers)
+        total += worker->nodes();
+    return total;
+}
+
+uint64_t Search::tbHits() const {
+    uint64_t total = 0;
+    for (const auto& worker : m_workers)
+        total += worker->tbHits();
+    return total;
+}
+
+int64_t Search::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - m_start).count();
+}
+
+void Search::startClock(const SearchLimits& limits, Color us) {
+    m_start = std::chrono::steady_clock::now();
+    m_nodeLimit = limits.nodes;
+    m_softLimitMs = 0;
+    m_hardLimitMs = 0;
+
+    if (limits.moveTimeMs > 0) {
+        m_softLimitMs = m_hardLimitMs = limits.moveTimeMs;
+    } else if (limits.timeLeftMs[us] > 0) {
+        int64_t left = limits.timeLeftMs[us];
+        int64_t increment = std::max(0, limits.incrementMs[us]);
+        int movesToGo = limits.movesToGo > 0 ? std::min(limits.movesToGo, 40) : 30;
+
+        // Keep a margin for the time it takes to report the move
+        int64_t usable = std::max<int64_t>(1, left - std::min<int64_t>(50, left / 10));
+        m_softLimitMs = std::min(usable, usable / movesToGo + increment * 3 / 4);
+        m_hardLimitMs = std::min(usable, m_softLimitMs * 4);
+    }
+}
+
+// Called by the main worker every few hundred nodes
+bool Search::checkLimits() {
+    if ((m_nodeLimit && nodesSearched() >= m_nodeLimit)
+        || (m_hardLimitMs && elapsedMs() >= m_hardLimitMs)) {
+        m_stop.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+SearchResult Search::run(const Position& root, const SearchLimits& limits, const std::vector<uint64_t>& history,
+                         uint64_t stopsSeen) {
+    // Clear the flag before comparing counts: stop() counts before it sets
+    // the flag, so a stop racing with this is either counted here or sets
+    // the flag again afterwards
+    m_stop.store(false);
+    if (stopsSeen != STOPS_AT_START && m_stopRequests.load() != stopsSeen)
+        m_stop.store(true);
+    startClock(limits, root.sideToMove());
+    m_tt.newSearch();
+
+    SearchResult result;
+    result.score = 0;
+    result.depth = 0;
+    result.nodes = 0;
+    result.tbHits = 0;
+    result.fromBook = false;
+
+    MoveList rootMoves;
+    generateLegalMoves(root, rootMoves);
+    if (rootMoves.isEmpty()) {
+        result.score = root.inCheck() ? -VALUE_MATE : VALUE_DRAW;
+        result.timeMs = elapsedMs();
+        return result;
+    }
+    // Something legal to play even if stopped before the first iteration ends
+    result.bestMove = rootMoves[0];
+
+    if (m_book) {
+        Move bookMove = m_book->pick(root, m_bookBestOnly, m_bookRandom());
+        if (!bookMove.isNull()) {
+            result.bestMove = bookMove;
+            result.pv.push_back(bookMove);
+            result.fromBook = true;
+            result.timeMs = elapsedMs();
+            return result;
+        }
+    }
+
+    // Only moves that keep the tablebase result are searched; if a table is
+    // missing the search runs as usual
+    if (m_tablebases && popCount(root.occupied()) <= m_tbPieces
+        && m_tablebases->filterRootMoves(root, rootMoves))
+        result.bestMove = rootMoves[0];
+    m_rootMoves = rootMoves;
+
+    int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+    for (auto& worker : m_workers)
+        worker->prepare(root, history);
+
+    TaskGroup helpers;
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+        SearchWorker* worker = m_workers[i].get();
+        m_pool->submit(helpers, [worker, maxDepth] {
+            SearchResult unused;
+            unused.depth = 0;
+            worker->iterate(maxDepth, unused);
+        });
+    }
+
+    m_workers[0]->iterate(maxDepth, result);
+
+    // Helpers keep going until the main worker is done
+    m_stop.store(true, std::memory_order_relaxed);
+    if (m_pool)
+        m_pool->wait(helpers);
+
+    result.nodes = nodesSearched();
+    result.tbHits = tbHits();
+    result.timeMs = elapsedMs();
+    return result;
+}
@@ -0,0 +1,185 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+// Alpha-beta engine over the headless position core.
+//
+// Iterative deepening drives a principal variation search with a
+// transposition table, null-move pruning, late move reductions and a
+// captures-only quiescence search. Moves are tried hash move first, then
+// captures by MVV-LVA, killer moves and quiet moves by history score.
+// Extra threads run the same search Lazy SMP style over the shared table.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Move.h"
+#include "PawnTable.h"
+#include "Position.h"
+
+class Book;
+class Tablebases;
+class TranspositionTable;
+
+const int MAX_PLY = 128;
+
+// Per search thread
+const size_t DEFAULT_PAWN_HASH_KB = 1024;
+
+const int VALUE_DRAW = 0;
+const int VALUE_MATE = 32000;
+const int VALUE_INFINITE = 32001;
+// Scores beyond this are mates; the distance is VALUE_MATE - |score| plies
+const int VALUE_MATE_IN_MAX_PLY = VALUE_MATE - MAX_PLY;
+// Tablebase wins rank below every mate, nearer ones higher
+const int VALUE_TB_WIN = VALUE_MATE_IN_MAX_PLY - 1;
+const int VALUE_TB_WIN_IN_MAX_PLY = VALUE_TB_WIN - MAX_PLY;
+
+// Zero or negative fields mean "no limit"; with no limits at all the search
+// runs until stop() is called.
+struct SearchLimits {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int moveTimeMs = 0;
+    // Clock mode: remaining time and increment for each side
+    int timeLeftMs[COLOR_NB] = {0, 0};
+    int incrementMs[COLOR_NB] = {0, 0};
+    int movesToGo = 0;
+};
+
+// Reported after every completed iteration.
+struct SearchInfo {
+    int depth;
+    int selDepth;
+    int score;
+    uint64_t nodes;
+    uint64_t tbHits;
+    int64_t timeMs;
+    std::vector<Move> pv;
+};
+
+struct SearchResult {
+    Move bestMove;
+    Move ponderMove;
+    int score;
+    int depth;
+    uint64_t nodes;
+    uint64_t tbHits;            // positions scored from endgame tablebases
+    int64_t timeMs;
+    std::vector<Move> pv;
+    bool fromBook;              // played from the opening book, unsearched
+};
+
+class SearchWorker;
+class ThreadPool;
+
+class Search {
+public:
+    // threads > 1 runs Lazy SMP: helper threads search the same root with
+    // staggered depths and share what they find through the table.
+    explicit Search(TranspositionTable& tt, int threads = 1);
+    ~Search();
+
+    Search(const Search&) = delete;
+    Search& operator=(const Search&) = delete;
+
+    // Not while a search is running.
+    void setThreads(int threads);
+    int threadCount() const { return static_cast<int>(m_workers.size()); }
+
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback) { m_onInfo = std::move(callback); }
+
+    // Play from book when it has a move for the root instead of searching;
+    // null turns the book off. The book must outlive its use here. With
+    // bestOnly the highest weighted move is played, otherwise a weighted
+    // random one.
+    void setBook(const Book* book, bool bestOnly = false) {
+        m_book = book;
+        m_bookBestOnly = bestOnly;
+    }
+
+    // Use endgame tablebases for positions of at most maxPieces pieces: the
+    // root moves are narrowed to those that keep the tablebase result, and
+    // positions reached by a capture or pawn move are scored from the tables
+    // instead of searched. Null turns probing off. The tables must outlive
+    // their use here.
+    void setTablebases(const Tablebases* tablebases, int maxPieces = 7) {
+        m_tablebases = tablebases;
+        m_tbPieces = maxPieces;
+    }
+
+    // Default for run()'s stopsSeen
+    static const uint64_t STOPS_AT_START = ~0ULL;
+
+    // Search root until a limit is hit or stop() is called. history holds the
+    // keys of the positions played before root, oldest first, so repetitions
+    // of earlier game positions are scored as draws.
+    //
+    // A caller that hands the search to another thread passes stopsSeen, its
+    // stopRequests() from before the hand-over: a stop() made in between then
+    // ends the run as soon as it starts instead of being lost. By default
+    // only stops made during the run count.
+    SearchResult run(const Position& root, const SearchLimits& limits,
+                     const std::vector<uint64_t>& history = std::vector<uint64_t>(),
+                     uint64_t stopsSeen = STOPS_AT_START);
+
+    // Safe to call from any thread; run() returns its best move so far.
+    void stop() {
+        m_stopRequests.fetch_add(1);
+        m_stop.store(true);
+    }
+    // How many times stop() has been called
+    uint64_t stopRequests() const { return m_stopRequests.load(); }
+
+    // Forget killer and history statistics, e.g. when a new game starts.
+    void clear();
+
+    // Nodes of all threads in the running or most recent search.
+    uint64_t nodesSearched() const;
+    uint64_t tbHits() const;
+
+    // Each thread caches pawn-structure evaluation in a table of this size.
+    // Not while a search is running.
+    void setPawnHashSize(size_t kilobytes);
+    // Pawn cache hits and misses of all threads in the most recent search.
+    PawnTableStats pawnHashStats() const;
+
+private:
+    friend class SearchWorker;
+
+    void startClock(const SearchLimits& limits, Color us);
+    bool checkLimits();
+    int64_t elapsedMs() const;
+
+    TranspositionTable& m_tt;
+    std::atomic<bool> m_stop;
+    std::atomic<uint64_t> m_stopRequests;
+    std::function<void(const SearchInfo&)> m_onInfo;
+
+    // Time and node budget of the running search
+    std::chrono::steady_clock::time_point m_start;
+    int64_t m_softLimitMs;
+    int64_t m_hardLimitMs;
+    uint64_t m_nodeLimit;
+
+    size_t m_pawnHashKb;
+
+    const Book* m_book;
+    bool m_bookBestOnly;
+    std::mt19937_64 m_bookRandom;
+
+    const Tablebases* m_tablebases;
+    int m_tbPieces;
+    // The moves searched at the root, narrowed by the tablebases
+    MoveList m_rootMoves;
+
+    // Worker 0 runs on the calling thread and owns the result; the others
+    // run on the pool.
+    std::vector<std::unique_ptr<SearchWorker>> m_workers;
+    std::unique_ptr<ThreadPool> m_pool;
+};
+
+#endif // SEARCH_H
@@ -0,0 +1,954 @@
+#include "Tablebases.h"
+#include "MappedFile.h"
+#include "MoveGen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+const uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+const uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+#if defined(_WIN32)
+const char PATH_SEPARATOR = ';';
+#else
+const char PATH_SEPARATOR = ':';
+#endif
+
+// Per-table flags in the first byte after the magic
+const uint8_t TB_SPLIT = 1;      // one subtable per side to move
+const uint8_t TB_HAS_PAWNS = 2;
+
+// Per-subtable flags
+const uint8_t PD_STM = 1;            // DTZ: the side to move it is stored for
+const uint8_t PD_MAPPED = 2;         // DTZ: values go through a map
+const uint8_t PD_WIN_PLIES = 4;      // DTZ: wins counted in plies, not moves
+const uint8_t PD_LOSS_PLIES = 8;
+const uint8_t PD_WIDE = 16;          // DTZ: the map holds 16-bit values
+const uint8_t PD_SINGLE_VALUE = 128; // every position has the same value
+
+inline uint16_t read16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+inline uint32_t read32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8
+         | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+inline uint32_t read32BigEndian(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+         | static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+}
+
+// Table files code pieces as type + 1, plus 8 for black
+inline int tbPiece(Piece pc) { return (typeOf(pc) + 1) | (colorOf(pc) == BLACK ? 8 : 0); }
+
+// Square's distance above (positive) or below the a1-h8 diagonal
+inline int offDiagonal(int sq) { return rankOf(sq) - fileOf(sq); }
+
+// Four bits per piece type, pawns to queens; kings are implied
+uint64_t sideSignature(const int counts[PIECE_TYPE_NB]) {
+    uint64_t signature = 0;
+    for (int pt = PAWN; pt < KING; ++pt)
+        signature |= static_cast<uint64_t>(counts[pt]) << (4 * pt);
+    return signature;
+}
+
+uint64_t materialKey(const Position& pos) {
+    int counts[COLOR_NB][PIECE_TYPE_NB];
+    for (int c = 0; c < COLOR_NB; ++c)
+        for (int pt = PAWN; pt < PIECE_TYPE_NB; ++pt)
+            counts[c][pt] = popCount(pos.pieces(static_cast<Color>(c), static_cast<PieceType>(pt)));
+    return sideSignature(counts[WHITE]) | sideSignature(counts[BLACK]) << 20;
+}
+
+// The indexing tables of the Syzygy encoding
+struct Encoding {
+    int mapB1H1H7[64];          // squares below the a1-h8 diagonal to 0..27
+    int mapA1D1D4[64];          // the a1-d1-d4 triangle to 0..9, diagonal last
+    int mapKK[10][64];          // the 462 placements of two kings
+    uint64_t binomial[MAX_TB_PIECES][64];
+    int mapPawns[64];           // a2-h7 to 0..47, edge files and low ranks highest
+    int leadPawnIdx[6][64];
+    int leadPawnsSize[6][4];
+
+    Encoding();
+};
+
+Encoding::Encoding() {
+    std::memset(this, 0, sizeof(*this));
+
+    int code = 0;
+    for (int sq = 0; sq < 64; ++sq)
+        if (offDiagonal(sq) < 0)
+            mapB1H1H7[sq] = code++;
+
+    code = 0;
+    int diagonal[4];
+    int diagonalCount = 0;
+    for (int sq = 0; sq <= makeSquare(3, 3); ++sq) {
+        if (fileOf(sq) > 3)
+            continue;
+        if (offDiagonal(sq) < 0)
+            mapA1D1D4[sq] = code++;
+        else if (offDiagonal(sq) == 0)
+            diagonal[diagonalCount++] = sq;
+    }
+    for (int i = 0; i < diagonalCount; ++i)
+        mapA1D1D4[diagonal[i]] = code++;
+
+    // With the first king on the diagonal the second may not be above it;
+    // placements with both on the diagonal come last
+    std::vector<std::pair<int, int>> bothOnDiagonal;
+    code = 0;
+    for (int idx = 0; idx < 10; ++idx) {
+        for (int s1 = 0; s1 <= makeSquare(3, 3); ++s1) {
+            if (fileOf(s1) > 3 || offDiagonal(s1) > 0 || mapA1D1D4[s1] != idx)
+                continue;
+            // Squares off the triangle also read 0; only b1 really is
+            if (idx == 0 && s1 != makeSquare(1, 0))
+                continue;
+            for (int s2 = 0; s2 < 64; ++s2) {
+                if (std::abs(fileOf(s1) - fileOf(s2)) <= 1 && std::abs(rankOf(s1) - rankOf(s2)) <= 1)
+                    continue;
+                if (offDiagonal(s1) == 0 && offDiagonal(s2) > 0)
+                    continue;
+                if (offDiagonal(s1) == 0 && offDiagonal(s2) == 0)
+                    bothOnDiagonal.emplace_back(idx, s2);
+                else
+                    mapKK[idx][s2] = code++;
+            }
+        }
+    }
+    for (const auto& p : bothOnDiagonal)
+        mapKK[p.first][p.second] = code++;
+
+    binomial[0][0] = 1;
+    for (int n = 1; n < 64; ++n)
+        for (int k = 0; k < MAX_TB_PIECES && k <= n; ++k)
+            binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+
+    int available = 47;
+    for (int leadPawns = 1; leadPawns <= 5; ++leadPawns) {
+        for (int file = 0; file < 4; ++file) {
+            int idx = 0;
+            for (int rank = 1; rank <= 6; ++rank) {
+                int sq = makeSquare(file, rank);
+                if (leadPawns == 1) {
+                    mapPawns[sq] = available--;
+                    mapPawns[sq ^ 7] = available--;
+                }
+                leadPawnIdx[leadPawns][sq] = idx;
+                idx += static_cast<int>(binomial[leadPawns - 1][mapPawns[sq]]);
+            }
+            leadPawnsSize[leadPawns][file] = idx;
+        }
+    }
+}
+
+const Encoding encoding;
+
+// One subtable: a side to move, and for pawn tables a file of the leading
+// pawn. Values are compressed by recursive pairing into symbols that are
+// stored as canonical Huffman codes in fixed-size blocks.
+struct PairsData {
+    uint8_t flags;
+    uint8_t minSymLen;          // the stored value itself for PD_SINGLE_VALUE
+    uint8_t maxSymLen;
+    uint64_t blockSize;
+    uint64_t span;              // values per sparse index entry
+    uint32_t blockCount;
+    const uint8_t* lowestSym;   // per code length, 16-bit
+    const uint8_t* btree;       // per symbol, two 12-bit children
+    const uint8_t* sparseIndex; // 6-byte entries: block, offset in block
+    size_t sparseIndexSize;
+    const uint8_t* blockLength; // 16-bit values per block, minus one
+    size_t blockLengthSize;
+    const uint8_t* data;
+    std::vector<uint64_t> base64;   // smallest left-aligned code per length
+    std::vector<uint8_t> symLen;    // values per symbol, minus one
+
+    int pieces[MAX_TB_PIECES] = {};
+    int groupLen[MAX_TB_PIECES + 1];    // zero terminated
+    uint64_t groupIdx[MAX_TB_PIECES + 1];
+    uint32_t mapIdx[4];             // DTZ map offsets by result
+
+    int left(int sym) const { return ((btree[3 * sym + 1] & 0xF) << 8) | btree[3 * sym]; }
+    int right(int sym) const { return (btree[3 * sym + 2] << 4) | (btree[3 * sym + 1] >> 4); }
+};
+
+struct TableFile {
+    MappedFile file;
+    std::atomic<bool> ready{false};
+    bool failed = false;
+    PairsData items[2][4];      // [side][file of the leading pawn]
+    const uint8_t* map = nullptr;
+};
+
+} // namespace
+
+struct Tablebases::Table {
+    std::string wdlPath;
+    std::string dtzPath;
+    uint64_t key;               // strong side white
+    uint64_t key2;              // strong side black; equal to key for symmetric tables
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+    int pawnCount[2];           // leading colour first
+    TableFile wdl;
+    TableFile dtz;
+
+    PairsData& get(TableFile& tf, int stm, int file) { return tf.items[stm][hasPawns ? file : 0]; }
+};
+
+namespace {
+
+// Split the pieces into the groups the index is built from and work out
+// each group's factor in it.
+void setGroups(const Tablebases::Table& t, PairsData& d, const int order[2], int file) {
+    const Encoding& e = encoding;
+    int n = 0;
+    int firstLen = t.hasPawns ? 0 : t.hasUniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+    for (int i = 1; i < t.pieceCount; ++i) {
+        if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1])
+            d.groupLen[n]++;
+        else
+            d.groupLen[++n] = 1;
+    }
+    d.groupLen[++n] = 0;
+
+    // The groups need not be encoded in board order: order[0] is where the
+    // leading group goes and order[1] where the other side's pawns go
+    bool bothPawns = t.hasPawns && t.pawnCount[1];
+    int next = bothPawns ? 2 : 1;
+    int freeSquares = 64 - d.groupLen[0] - (bothPawns ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+    for (int k = 0; next < n || k == order[0] || k == order[1]; ++k) {
+        if (k == order[0]) {
+            d.groupIdx[0] = idx;
+            idx *= t.hasPawns ? e.leadPawnsSize[d.groupLen[0]][file] : t.hasUniquePieces ? 31332 : 462;
+        } else if (k == order[1]) {
+            d.groupIdx[1] = idx;
+            idx *= e.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+        } else {
+            d.groupIdx[next] = idx;
+            idx *= e.binomial[d.groupLen[next]][freeSquares];
+            freeSquares -= d.groupLen[next++];
+        }
+    }
+    d.groupIdx[n] = idx;
+}
+
+int setSymLen(PairsData& d, int sym, std::vector<bool>& visited) {
+    visited[sym] = true;
+    int r = d.right(sym);
+    if (r == 0xFFF)
+        return 0;
+    int l = d.left(sym);
+    int symbols = static_cast<int>(d.symLen.size());
+    if (l >= symbols || r >= symbols)
+        return -1;
+    for (int child : {l, r}) {
+        if (!visited[child]) {
+            int len = setSymLen(d, child, visited);
+            if (len < 0)
+                return -1;
+            d.symLen[child] = static_cast<uint8_t>(len);
+        }
+    }
+    return d.symLen[l] + d.symLen[r] + 1;
+}
+
+// Read a subtable's compression parameters; null if they run past end.
+const uint8_t* setSizes(PairsData& d, const uint8_t* data, const uint8_t* end) {
+    if (end - data < 2)
+        return nullptr;
+    d.flags = *data++;
+    if (d.flags & PD_SINGLE_VALUE) {
+        d.blockCount = 0;
+        d.blockLengthSize = d.sparseIndexSize = 0;
+        d.blockSize = d.span = 0;
+        d.minSymLen = *data++;
+        return data;
+    }
+
+    if (end - data < 9)
+        return nullptr;
+    uint64_t tableSize = d.groupIdx[std::find(d.groupLen, d.groupLen + MAX_TB_PIECES, 0) - d.groupLen];
+    d.blockSize = 1ULL << data[0];
+    d.span = 1ULL << data[1];
+    d.sparseIndexSize = static_cast<size_t>((tableSize + d.span - 1) / d.span);
+    int padding = data[2];
+    d.blockCount = read32(data + 3);
+    d.blockLengthSize = d.blockCount + padding;
+    d.maxSymLen = data[7];
+    d.minSymLen = data[8];
+    data += 9;
+    if (d.minSymLen < 1 || d.maxSymLen < d.minSymLen || d.maxSymLen > 32)
+        return nullptr;
+
+    // Canonical Huffman code: longer codes have lower values, and all codes
+    // of one length are consecutive from the lowest symbol of that length
+    size_t lengths = d.maxSymLen - d.minSymLen + 1;
+    if (static_cast<size_t>(end - data) < 2 * lengths + 2)
+        return nullptr;
+    d.lowestSym = data;
+    d.base64.assign(lengths, 0);
+    for (int i = static_cast<int>(lengths) - 2; i >= 0; --i)
+        d.base64[i] = (d.base64[i + 1] + read16(d.lowestSym + 2 * i) - read16(d.lowestSym + 2 * (i + 1))) / 2;
+    for (size_t i = 0; i < lengths; ++i)
+        d.base64[i] <<= 64 - i - d.minSymLen;
+    data += 2 * lengths;
+
+    size_t symbols = read16(data);
+    data += 2;
+    if (static_cast<size_t>(end - data) < 3 * symbols + (symbols & 1))
+        return nullptr;
+    d.btree = data;
+    d.symLen.assign(symbols, 0);
+    std::vector<bool> visited(symbols);
+    for (size_t sym = 0; sym < symbols; ++sym) {
+        if (visited[sym])
+            continue;
+        int len = setSymLen(d, static_cast<int>(sym), visited);
+        if (len < 0)
+            return nullptr;
+        d.symLen[sym] = static_cast<uint8_t>(len);
+    }
+    return data + 3 * symbols + (symbols & 1);
+}
+
+// The value at idx of a subtable
+int decompressPairs(const PairsData& d, uint64_t idx) {
+    if (d.flags & PD_SINGLE_VALUE)
+        return d.minSymLen;
+
+    // Sparse index entry k points at the value with index k * span + span / 2;
+    // walk the block lengths from there to the block that holds idx
+    uint64_t k = idx / d.span;
+    const uint8_t* entry = d.sparseIndex + 6 * k;
+    uint32_t block = read32(entry);
+    int offset = read16(entry + 4);
+    offset += static_cast<int>(idx % d.span) - static_cast<int>(d.span / 2);
+    while (offset < 0)
+        offset += read16(d.blockLength + 2 * --block) + 1;
+    while (offset > read16(d.blockLength + 2 * block))
+        offset -= read16(d.blockLength + 2 * block++) + 1;
+
+    // Decode symbols from the start of the block until the one covering offset
+    const uint8_t* ptr = d.data + block * d.blockSize;
+    uint64_t buf64 = static_cast<uint64_t>(read32BigEndian(ptr)) << 32 | read32BigEndian(ptr + 4);
+    ptr += 8;
+    int buf64Size = 64;
+    int sym;
+    while (true) {
+        int len = 0;
+        while (buf64 < d.base64[len])
+            ++len;
+        sym = static_cast<int>((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+        sym += read16(d.lowestSym + 2 * len);
+        if (offset < d.symLen[sym] + 1)
+            break;
+        offset -= d.symLen[sym] + 1;
+        len += d.minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+        if (buf64Size <= 32) {
+            buf64Size += 32;
+            buf64 |= static_cast<uint64_t>(read32BigEndian(ptr)) << (64 - buf64Size);
+            ptr += 4;
+        }
+    }
+
+    // A symbol stands for a pair of symbols; descend to the value at offset
+    while (d.symLen[sym]) {
+        int l = d.left(sym);
+        if (offset < d.symLen[l] + 1) {
+            sym = l;
+        } else {
+            offset -= d.symLen[l] + 1;
+            sym = d.right(sym);
+        }
+    }
+    return d.left(sym);
+}
+
+// Parse a mapped table file; false if it is not laid out as t expects.
+bool parseTable(Tablebases::Table& t, TableFile& tf, bool dtz) {
+    const uint8_t* base = tf.file.data();
+    const uint8_t* end = base + tf.file.size();
+    const uint8_t* data = base + 4;
+    if (bool(*data & TB_HAS_PAWNS) != t.hasPawns || bool(*data & TB_SPLIT) != (t.key != t.key2))
+        return false;
+    ++data;
+
+    int sides = !dtz && t.key != t.key2 ? 2 : 1;
+    int files = t.hasPawns ? 4 : 1;
+    bool bothPawns = t.hasPawns && t.pawnCount[1];
+    for (int f = 0; f < files; ++f) {
+        if (end - data < 1 + bothPawns + t.pieceCount)
+            return false;
+        int order[2][2] = {{data[0] & 0xF, bothPawns ? data[1] & 0xF : 0xF},
+                           {data[0] >> 4, bothPawns ? data[1] >> 4 : 0xF}};
+        data += 1 + bothPawns;
+        for (int k = 0; k < t.pieceCount; ++k, ++data)
+            for (int i = 0; i < sides; ++i)
+                t.get(tf, i, f).pieces[k] = i ? *data >> 4 : *data & 0xF;
+        for (int i = 0; i < sides; ++i)
+            setGroups(t, t.get(tf, i, f), order[i], f);
+    }
+    data += (data - base) & 1;
+
+    for (int f = 0; f < files; ++f)
+        for (int i = 0; i < sides; ++i)
+            if (!(data = setSizes(t.get(tf, i, f), data, end)))
+                return false;
+
+    if (dtz) {
+        tf.map = data;
+        for (int f = 0; f < files; ++f) {
+            PairsData& d = t.get(tf, 0, f);
+            if (!(d.flags & PD_MAPPED))
+                continue;
+            // One value list per result: win, loss, cursed win, blessed loss
+            if (d.flags & PD_WIDE) {
+                data += (data - base) & 1;
+                for (int i = 0; i < 4; ++i) {
+                    if (end - data < 2)
+                        return false;
+                    d.mapIdx[i] = static_cast<uint32_t>(data - tf.map + 2);
+                    data += 2 * read16(data) + 2;
+                }
+            } else {
+                for (int i = 0; i < 4; ++i) {
+                    if (end - data < 1)
+                        return false;
+                    d.mapIdx[i] = static_cast<uint32_t>(data - tf.map + 1);
+                    data += *data + 1;
+                }
+            }
+        }
+        data += (data - base) & 1;
+    }
+
+    for (int f = 0; f < files; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData& d = t.get(tf, i, f);
+            d.sparseIndex = data;
+            data += 6 * d.sparseIndexSize;
+        }
+    }
+    for (int f = 0; f < files; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData& d = t.get(tf, i, f);
+            d.blockLength = data;
+            data += 2 * d.blockLengthSize;
+        }
+    }
+    for (int f = 0; f < files; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData& d = t.get(tf, i, f);
+            data += (64 - (data - base) % 64) % 64;
+            d.data = data;
+            data += d.blockCount * d.blockSize;
+        }
+    }
+    return data <= end;
+}
+
+// Parse a file name such as "KRPvKR" into piece counts per side.
+bool parseTableName(const std::string& name, int counts[2][PIECE_TYPE_NB]) {
+    std::memset(counts, 0, sizeof(int) * 2 * PIECE_TYPE_NB);
+    size_t v = name.find('v');
+    if (v == std::string::npos || v == 0 || v + 1 >= name.size())
+        return false;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (i == v)
+            continue;
+        int side = i < v ? 0 : 1;
+        const char* p = std::strchr("PNBRQK", name[i]);
+        if (!p)
+            return false;
+        counts[side][p - "PNBRQK"]++;
+    }
+    return counts[0][KING] == 1 && counts[1][KING] == 1;
+}
+
+// The result before a zeroing move, counted from the position it is made in
+int dtzBeforeZeroing(WdlScore wdl) {
+    switch (wdl) {
+    case WDL_WIN: return 1;
+    case WDL_CURSED_WIN: return 101;
+    case WDL_BLESSED_LOSS: return -101;
+    case WDL_LOSS: return -1;
+    default: return 0;
+    }
+}
+
+inline int signOf(int v) { return (v > 0) - (v < 0); }
+
+bool isZeroing(const Position& pos, Move m) {
+    return m.isCapture() || typeOf(pos.pieceOn(m.from())) == PAWN;
+}
+
+} // namespace
+
+Tablebases::Tablebases() : m_maxPieces(0), m_pieceLimit(MAX_TB_PIECES) {}
+
+Tablebases::~Tablebases() = default;
+
+void Tablebases::clear() {
+    m_byKey.clear();
+    m_tables.clear();
+    m_maxPieces = 0;
+}
+
+int Tablebases::init(const std::string& path, int maxPieces) {
+    clear();
+    m_pieceLimit = std::min(maxPieces, MAX_TB_PIECES);
+
+    std::vector<std::filesystem::path> dirs;
+    for (size_t start = 0; start <= path.size();) {
+        size_t stop = path.find(PATH_SEPARATOR, start);
+        if (stop == std::string::npos)
+            stop = path.size();
+        if (stop > start)
+            dirs.emplace_back(path.substr(start, stop - start));
+        start = stop + 1;
+    }
+
+    for (const auto& dir : dirs) {
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(dir, ec), last; !ec && it != last; it.increment(ec)) {
+            const std::filesystem::path& file = it->path();
+            if (file.extension() != ".rtbw")
+                continue;
+            int counts[2][PIECE_TYPE_NB];
+            if (!parseTableName(file.stem().string(), counts))
+                continue;
+            int pieceCount = 0;
+            for (int pt = PAWN; pt < PIECE_TYPE_NB; ++pt)
+                pieceCount += counts[0][pt] + counts[1][pt];
+            uint64_t key = sideSignature(counts[0]) | sideSignature(counts[1]) << 20;
+            if (pieceCount > m_pieceLimit || m_byKey.count(key))
+                continue;
+
+            std::unique_ptr<Table> t(new Table);
+            t->wdlPath = file.string();
+            // The DTZ file may sit in any of the directories
+            std::filesystem::path dtzName = file.filename();
+            dtzName.replace_extension(".rtbz");
+            t->dtzPath = (dir / dtzName).string();
+            for (const auto& other : dirs) {
+                if (std::filesystem::exists(other / dtzName, ec)) {
+                    t->dtzPath = (other / dtzName).string();
+                    break;
+                }
+            }
+
+            t->key = key;
+            t->key2 = sideSignature(counts[1]) | sideSignature(counts[0]) << 20;
+            t->pieceCount = pieceCount;
+            t->hasPawns = counts[0][PAWN] || counts[1][PAWN];
+            t->hasUniquePieces = false;
+            for (int side = 0; side < 2; ++side)
+                for (int pt = PAWN; pt < KING; ++pt)
+                    if (counts[side][pt] == 1)
+                        t->hasUniquePieces = true;
+            // Pawns lead from the side with fewer of them, white on a tie
+            bool whiteLeads = !counts[1][PAWN] || (counts[0][PAWN] && counts[1][PAWN] >= counts[0][PAWN]);
+            t->pawnCount[0] = whiteLeads ? counts[0][PAWN] : counts[1][PAWN];
+            t->pawnCount[1] = whiteLeads ? counts[1][PAWN] : counts[0][PAWN];
+
+            m_byKey[t->key] = t.get();
+            m_byKey[t->key2] = t.get();
+            m_maxPieces = std::max(m_maxPieces, pieceCount);
+            m_tables.push_back(std::move(t));
+        }
+    }
+    return tableCount();
+}
+
+bool Tablebases::covers(const Position& pos) const {
+    return !pos.castlingRights() && popCount(pos.occupied()) <= m_maxPieces;
+}
+
+// Map and parse a table file on first use. Probes that find it ready skip
+// the lock.
+bool Tablebases::map(Table& t, bool dtz) const {
+    TableFile& tf = dtz ? t.dtz : t.wdl;
+    if (tf.ready.load(std::memory_order_acquire))
+        return !tf.failed;
+
+    std::lock_guard<std::mutex> lock(m_mapMutex);
+    if (tf.ready.load(std::memory_order_relaxed))
+        return !tf.failed;
+
+    const uint8_t* magic = dtz ? DTZ_MAGIC : WDL_MAGIC;
+    // Files end with a 16-byte checksum after 64-byte aligned data
+    tf.failed = !tf.file.open((dtz ? t.dtzPath : t.wdlPath).c_str())
+             || tf.file.size() % 64 != 16
+             || std::memcmp(tf.file.data(), magic, 4) != 0
+             || !parseTable(t, tf, dtz);
+    if (tf.failed)
+        tf.file.close();
+    tf.ready.store(true, std::memory_order_release);
+    return !tf.failed;
+}
+
+namespace {
+
+// Index of pos in the subtable it belongs to. The tables hold the stronger
+// side as white, so pos is first recoloured and flipped to match, then
+// mirrored into the canonical region, and finally each group of pieces is
+// numbered as a combination of its squares.
+struct TableIndex {
+    PairsData* d;
+    uint64_t idx;
+};
+
+bool indexOf(const Position& pos, Tablebases::Table& t, TableFile& tf, bool dtz, TableIndex& out, bool& otherSide) {
+    const Encoding& e = encoding;
+    int squares[MAX_TB_PIECES] = {};
+    int pieces[MAX_TB_PIECES] = {};
+    int size = 0;
+    int leadPawnsCount = 0;
+    Bitboard leadPawns = 0;
+    int tbFile = 0;
+
+    // Symmetric tables hold only white to move
+    bool symmetricBlackToMove = t.key == t.key2 && pos.sideToMove() == BLACK;
+    bool blackStronger = materialKey(pos) != t.key;
+    bool flip = symmetricBlackToMove || blackStronger;
+    int flipColor = flip ? 8 : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = flip ^ (pos.sideToMove() == BLACK);
+
+    auto pawnsLess = [&e](int a, int b) { return e.mapPawns[a] < e.mapPawns[b]; };
+
+    if (t.hasPawns) {
+        // The leading pawns are first in every subtable's piece list
+        int pc = tf.items[0][0].pieces[0] ^ flipColor;
+        Color leadColor = pc & 8 ? BLACK : WHITE;
+        leadPawns = pos.pieces(leadColor, PAWN);
+        for (Bitboard b = leadPawns; b;)
+            squares[size++] = popLsb(b) ^ flipSquares;
+        leadPawnsCount = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount, pawnsLess));
+        tbFile = std::min(fileOf(squares[0]), 7 - fileOf(squares[0]));
+    }
+
+    // DTZ tables hold one side to move; the caller searches a ply for the other
+    PairsData& first = t.get(tf, dtz ? 0 : stm, tbFile);
+    if (dtz && (first.flags & PD_STM) != stm && (t.key != t.key2 || t.hasPawns)) {
+        otherSide = true;
+        return true;
+    }
+
+    for (Bitboard b = pos.occupied() ^ leadPawns; b;) {
+        int sq = popLsb(b);
+        squares[size] = sq ^ flipSquares;
+        pieces[size++] = tbPiece(pos.pieceOn(sq)) ^ flipColor;
+    }
+
+    PairsData* d = &first;
+
+    // Order the pieces as the subtable lists them
+    for (int i = leadPawnsCount; i < size - 1; ++i) {
+        for (int j = i + 1; j < size; ++j) {
+            if (d->pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // Mirror so the leading piece is on files a-d
+    if (fileOf(squares[0]) > 3)
+        for (int i = 0; i < size; ++i)
+            squares[i] ^= 7;
+
+    uint64_t idx;
+    if (t.hasPawns) {
+        idx = e.leadPawnIdx[leadPawnsCount][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCount, pawnsLess);
+        for (int i = 1; i < leadPawnsCount; ++i)
+            idx += e.binomial[i][e.mapPawns[squares[i]]];
+    } else {
+        // Without pawns also mirror the leading piece to ranks 1-4, then below
+        // the a1-h8 diagonal if the first leading piece off it is above it
+        if (rankOf(squares[0]) > 3)
+            for (int i = 0; i < size; ++i)
+                squares[i] ^= 56;
+        for (int i = 0; i < d->groupLen[0]; ++i) {
+            if (!offDiagonal(squares[i]))
+                continue;
+            if (offDiagonal(squares[i]) > 0)
+                for (int j = i; j < size; ++j)
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            break;
+        }
+
+        if (t.hasUniquePieces) {
+            // Three unique pieces are encoded together
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (offDiagonal(squares[0]))
+                idx = (e.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (offDiagonal(squares[1]))
+                idx = (6 * 63 + rankOf(squares[0]) * 28 + e.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (offDiagonal(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28
+                    + (rankOf(squares[1]) - adjust1) * 28 + e.mapB1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6
+                    + (rankOf(squares[1]) - adjust1) * 6 + (rankOf(squares[2]) - adjust2);
+        } else {
+            idx = e.mapKK[e.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // The remaining groups by square, skipping squares taken by earlier groups
+    idx *= d->groupIdx[0];
+    int* groupSq = squares + d->groupLen[0];
+    bool remainingPawns = t.hasPawns && t.pawnCount[1];
+    for (int next = 1; d->groupLen[next]; ++next) {
+        std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d->groupLen[next]; ++i) {
+            int adjust = 0;
+            for (const int* s = squares; s < groupSq; ++s)
+                adjust += groupSq[i] > *s;
+            n += e.binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+        }
+        remainingPawns = false;
+        idx += n * d->groupIdx[next];
+        groupSq += d->groupLen[next];
+    }
+
+    out.d = d;
+    out.idx = idx;
+    return true;
+}
+
+} // namespace
+
+WdlScore Tablebases::probeTable(const Position& pos, bool& ok) const {
+    if (popCount(pos.occupied()) == 2)
+        return WDL_DRAW;
+    auto it = m_byKey.find(materialKey(pos));
+    if (it == m_byKey.end() || !map(*it->second, false)) {
+        ok = false;
+        return WDL_DRAW;
+    }
+    Table& t = *it->second;
+    TableIndex index;
+    bool otherSide = false;
+    indexOf(pos, t, t.wdl, false, index, otherSide);
+    return static_cast<WdlScore>(decompressPairs(*index.d, index.idx) - 2);
+}
+
+// DTZ of pos from its table, in plies; otherSide if the table only holds
+// the other side to move.
+int Tablebases::probeDtzTable(const Position& pos, WdlScore wdl, bool& ok, bool& otherSide) const {
+    auto it = m_byKey.find(materialKey(pos));
+    if (it == m_byKey.end() || !map(*it->second, true)) {
+        ok = false;
+        return 0;
+    }
+    Table& t = *it->second;
+    TableIndex index;
+    otherSide = false;
+    indexOf(pos, t, t.dtz, true, index, otherSide);
+    if (otherSide)
+        return 0;
+
+    const PairsData& d = *index.d;
+    int value = decompressPairs(d, index.idx);
+    if (d.flags & PD_MAPPED) {
+        static const int resultMap[] = {1, 3, 0, 2, 0};
+        uint32_t offset = d.mapIdx[resultMap[wdl + 2]];
+        if (d.flags & PD_WIDE)
+            value = read16(t.dtz.map + offset + 2 * value);
+        else
+            value = t.dtz.map[offset + value];
+    }
+    // Stored in moves unless flagged as plies
+    if ((wdl == WDL_WIN && !(d.flags & PD_WIN_PLIES)) || (wdl == WDL_LOSS && !(d.flags & PD_LOSS_PLIES))
+        || wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS)
+        value *= 2;
+    return value + 1;
+}
+
+// Best result of pos over its captures (and pawn moves, with zeroingMoves)
+// and the table. Tables store "don't care" values where a capture wins, so
+// the table alone is not enough. zeroingBest is set when the result comes
+// from such a move; the DTZ table cannot be trusted then.
+WdlScore Tablebases::searchCaptures(Position& pos, bool zeroingMoves, bool& ok, bool& zeroingBest) const {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    WdlScore best = WDL_LOSS;
+    int tried = 0;
+    UndoInfo undo;
+    for (Move m : moves) {
+        if (!m.isCapture() && !(zeroingMoves && typeOf(pos.pieceOn(m.from())) == PAWN))
+            continue;
+        ++tried;
+        bool unused;
+        pos.makeMove(m, undo);
+        WdlScore value = static_cast<WdlScore>(-searchCaptures(pos, false, ok, unused));
+        pos.unmakeMove(m, undo);
+        if (!ok)
+            return WDL_DRAW;
+        if (value > best) {
+            best = value;
+            if (value >= WDL_WIN) {
+                zeroingBest = true;
+                return value;
+            }
+        }
+    }
+
+    // With every legal move tried the table is not needed, and it may hold a
+    // wrong value: it knows nothing of en-passant rights
+    bool allTried = tried && tried == moves.size();
+    WdlScore value = allTried ? best : probeTable(pos, ok);
+    if (!ok)
+        return WDL_DRAW;
+    if (best >= value) {
+        zeroingBest = best > WDL_DRAW || allTried;
+        return best;
+    }
+    zeroingBest = false;
+    return value;
+}
+
+WdlScore Tablebases::wdlOf(Position& pos, bool& ok) const {
+    bool zeroingBest;
+    return searchCaptures(pos, false, ok, zeroingBest);
+}
+
+int Tablebases::dtzOf(Position& pos, bool& ok) const {
+    bool zeroingBest = false;
+    WdlScore wdl = searchCaptures(pos, true, ok, zeroingBest);
+    if (!ok || wdl == WDL_DRAW)
+        return 0;
+    if (zeroingBest)
+        return dtzBeforeZeroing(wdl);
+
+    bool otherSide;
+    int dtz = probeDtzTable(pos, wdl, ok, otherSide);
+    if (!ok)
+        return 0;
+    if (!otherSide)
+        return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * signOf(wdl);
+
+    // The table holds the other side to move: take the best reply's DTZ
+    int minDtz = 0xFFFF;
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    UndoInfo undo;
+    for (Move m : moves) {
+        bool zeroing = isZeroing(pos, m);
+        pos.makeMove(m, undo);
+        // A zeroing move's DTZ is counted before it is made; the position
+        // after it gives only the sign
+        int value = zeroing ? -dtzBeforeZeroing(wdlOf(pos, ok)) : -dtzOf(pos, ok);
+        if (value == 1 && pos.inCheck()) {
+            MoveList replies;
+            generateLegalMoves(pos, replies);
+            if (replies.isEmpty())
+                minDtz = 1;
+        }
+        if (!zeroing)
+            value += signOf(value);
+        if (value < minDtz && signOf(value) == signOf(wdl))
+            minDtz = value;
+        pos.unmakeMove(m, undo);
+        if (!ok)
+            return 0;
+    }
+    // No legal move: the side to move is mated
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+bool Tablebases::probeWdl(const Position& pos, WdlScore& wdl) const {
+    if (!covers(pos))
+        return false;
+    Position copy = pos;
+    bool ok = true;
+    wdl = wdlOf(copy, ok);
+    return ok;
+}
+
+bool Tablebases::probeDtz(const Position& pos, int& dtz) const {
+    if (!covers(pos))
+        return false;
+    Position copy = pos;
+    bool ok = true;
+    dtz = dtzOf(copy, ok);
+    return ok;
+}
+
+bool Tablebases::filterRootMoves(const Position& root, MoveList& moves, WdlScore* rootWdl) const {
+    if (!covers(root) || moves.isEmpty())
+        return false;
+
+    // Rank each move by its outcome tier, then by DTZ within the tier
+    Position pos = root;
+    int clock = pos.halfmoveClock();
+    int tiers[MAX_MOVES];
+    int dtzs[MAX_MOVES];
+    bool ok = true;
+    UndoInfo undo;
+    for (int i = 0; i < moves.size(); ++i) {
+        Move m = moves[i];
+        pos.makeMove(m, undo);
+        int dtz;
+        if (pos.halfmoveClock() == 0) {
+            dtz = dtzBeforeZeroing(static_cast<WdlScore>(-wdlOf(pos, ok)));
+        } else {
+            dtz = -dtzOf(pos, ok);
+            dtz += signOf(dtz);
+        }
+        if (dtz == 2 && pos.inCheck()) {
+            MoveList replies;
+            generateLegalMoves(pos, replies);
+            if (replies.isEmpty())
+                dtz = 1;
+        }
+        pos.unmakeMove(m, undo);
+        if (!ok)
+            return false;
+
+        // The counter must be zeroed again before it reaches 100
+        dtzs[i] = dtz;
+        tiers[i] = dtz > 0 ? (dtz + clock <= 100 ? WDL_WIN : WDL_CURSED_WIN)
+                 : dtz < 0 ? (-dtz + clock <= 100 ? WDL_LOSS : WDL_BLESSED_LOSS)
+                 : WDL_DRAW;
+    }
+
+    auto better = [&](int a, int b) {
+        if (tiers[a] != tiers[b])
+            return tiers[a] > tiers[b];
+        // Win fast, lose slowly; all draws are equal
+        return tiers[a] != WDL_DRAW && dtzs[a] < dtzs[b];
+    };
+    int best = 0;
+    for (int i = 1; i < moves.size(); ++i)
+        if (better(i, best))
+            best = i;
+
+    MoveList kept;
+    for (int i = 0; i < moves.size(); ++i)
+        if (!better(best, i))
+            kept.add(moves[i]);
+    moves = kept;
+    if (rootWdl)
+        *rootWdl = static_cast<WdlScore>(tiers[best]);
+    return true;
+}
@@ -0,0 +1,96 @@
+#ifndef TABLEBASES_H
+#define TABLEBASES_H
+
+// Syzygy endgame tablebases, read through memory mappings.
+//
+// init() only lists the .rtbw (win/draw/loss) and .rtbz (distance to
+// zeroing) files it finds on the path. A table file is mapped and its
+// header parsed the first time a probe needs it, and a probe decompresses
+// only the one block holding its position, so a probe costs a few page
+// touches and no file reads.
+//
+// Tables leave out positions with castling rights. They also leave out
+// positions where the side to move has a winning capture, so every probe
+// first tries the captures itself.
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Move.h"
+#include "Position.h"
+
+// Result for the side to move. A cursed win is won only by breaking the
+// fifty-move rule, and a blessed loss is lost only that way.
+enum WdlScore : int8_t {
+    WDL_LOSS = -2,
+    WDL_BLESSED_LOSS = -1,
+    WDL_DRAW = 0,
+    WDL_CURSED_WIN = 1,
+    WDL_WIN = 2
+};
+
+// The largest Syzygy tables published
+const int MAX_TB_PIECES = 7;
+
+class Tablebases {
+public:
+    Tablebases();
+    ~Tablebases();
+
+    Tablebases(const Tablebases&) = delete;
+    Tablebases& operator=(const Tablebases&) = delete;
+
+    // Forget the current tables and register those found in the directories
+    // of path, separated by ':' (';' on Windows), with at most maxPieces
+    // pieces. Returns how many WDL tables were found. Not while probing.
+    int init(const std::string& path, int maxPieces = MAX_TB_PIECES);
+    void clear();
+
+    int tableCount() const { return static_cast<int>(m_tables.size()); }
+    // Pieces of the largest table found, zero without tables
+    int maxPieces() const { return m_maxPieces; }
+
+    // Whether pos could be in a table: few enough pieces, no castling rights.
+    bool covers(const Position& pos) const;
+
+    // False if pos is not covered or a table it needs is missing or corrupt.
+    // Safe to call from several threads at once.
+    bool probeWdl(const Position& pos, WdlScore& wdl) const;
+
+    // Plies to the next capture or pawn move on the best path for both
+    // sides, positive when the side to move wins and negative when it loses,
+    // counted past 100 for cursed wins and blessed losses. 0 for a draw and
+    // -1 for a checkmated side to move.
+    bool probeDtz(const Position& pos, int& dtz) const;
+
+    // Narrow moves, the legal moves of pos, to those that keep the best
+    // outcome the tables give under the fifty-move rule: among wins the
+    // fastest to zero the counter, among losses the slowest, and every
+    // drawing move. False, leaving moves untouched, if a table is missing.
+    bool filterRootMoves(const Position& pos, MoveList& moves, WdlScore* rootWdl = nullptr) const;
+
+    // One material signature's files; defined with the decoder
+    struct Table;
+
+private:
+    bool map(Table& table, bool dtz) const;
+
+    WdlScore probeTable(const Position& pos, bool& ok) const;
+    int probeDtzTable(const Position& pos, WdlScore wdl, bool& ok, bool& otherSide) const;
+    WdlScore searchCaptures(Position& pos, bool zeroingMoves, bool& ok, bool& zeroingBest) const;
+    WdlScore wdlOf(Position& pos, bool& ok) const;
+    int dtzOf(Position& pos, bool& ok) const;
+
+    std::vector<std::unique_ptr<Table>> m_tables;
+    std::unordered_map<uint64_t, Table*> m_byKey;   // both colour assignments of each table
+    int m_maxPieces;
+    int m_pieceLimit;
+
+    // Serialises the first mapping of each file
+    mutable std::mutex m_mapMutex;
+};
+
+#endif // TABLEBASES_H
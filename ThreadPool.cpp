@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+
+// Index of the deque owned by the current thread; 0 for threads outside the pool.
+static thread_local int currentQueue = 0;
+static thread_local const ThreadPool* currentPool = nullptr;
+
+ThreadPool::ThreadPool(int threads)
+    : m_queued(0), m_idle(0), m_stop(false) {
+    if (threads < 1)
+        threads = 1;
+
+    for (int i = 0; i < threads; ++i)
+        m_queues.emplace_back(new WorkQueue);
+
+    for (int i = 1; i < threads; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+int ThreadPool::hardwareThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? static_cast<int>(n) : 1;
+}
+
+void ThreadPool::submit(TaskGroup& group, std::function<void()> task) {
+    int index = (currentPool == this) ? currentQueue : 0;
+    group.m_pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(Task{std::move(task), &group});
+    }
+    // Sequentially consistent pair with the idle count in workerLoop so a
+    // worker going to sleep either sees this task or gets notified.
+    m_queued.fetch_add(1);
+
+    if (m_idle.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_one();
+    }
+}
+
+bool ThreadPool::popLocal(int index, Task& task) {
+    WorkQueue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+// Take the oldest task from another deque; old tasks tend to be the biggest subtrees.
+bool ThreadPool::steal(int thief, Task& task) {
+    int count = static_cast<int>(m_queues.size());
+    for (int i = 1; i < count; ++i) {
+        WorkQueue& queue = *m_queues[(thief + i) % count];
+        std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || queue.tasks.empty())
+            continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::findTask(int index, Task& task) {
+    if (m_queued.load(std::memory_order_acquire) == 0)
+        return false;
+    if (popLocal(index, task) || steal(index, task)) {
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::execute(Task& task) {
+    task.run();
+    task.group->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    const ThreadPool* previousPool = currentPool;
+    int previousQueue = currentQueue;
+    if (currentPool != this) {
+        currentPool = this;
+        currentQueue = 0;
+    }
+
+    while (!group.isDone()) {
+        Task task;
+        if (findTask(currentQueue, task))
+            execute(task);
+        else
+            std::this_thread::yield();
+    }
+
+    currentPool = previousPool;
+    currentQueue = previousQueue;
+}
+
+void ThreadPool::workerLoop(int index) {
+    currentPool = this;
+    currentQueue = index;
+
+    while (true) {
+        Task task;
+        if (findTask(index, task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_idle.fetch_add(1);
+        m_wake.wait(lock, [this] {
+            return m_stop.load() || m_queued.load() > 0;
+        });
+        m_idle.fetch_sub(1);
+
+        if (m_stop.load() && m_queued.load() == 0)
+            return;
+    }
+}
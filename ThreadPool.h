@@ -0,0 +1,79 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Work-stealing thread pool for the headless core.
+//
+// Each worker owns a deque: it pushes and pops its own tasks at the back
+// (depth first) and steals from the front of other deques when it runs dry,
+// so tasks that fan out into more tasks spread over idle cores on their own.
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks the outstanding tasks submitted under it so a caller can wait for them.
+class TaskGroup {
+public:
+    TaskGroup() : m_pending(0) {}
+    bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class ThreadPool;
+    std::atomic<int> m_pending;
+};
+
+class ThreadPool {
+public:
+    // threads counts the caller as well: threads - 1 background workers are
+    // started and wait() runs tasks on the calling thread.
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int threadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+    int idleWorkers() const { return m_idle.load(std::memory_order_relaxed); }
+
+    // Queue a task on the current thread's deque. Tasks may submit more tasks.
+    void submit(TaskGroup& group, std::function<void()> task);
+
+    // Run and steal tasks until every task of the group has finished.
+    void wait(TaskGroup& group);
+
+    static int hardwareThreads();
+
+private:
+    struct Task {
+        std::function<void()> run;
+        TaskGroup* group;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool popLocal(int index, Task& task);
+    bool steal(int thief, Task& task);
+    bool findTask(int index, Task& task);
+    void execute(Task& task);
+    void workerLoop(int index);
+
+    // Queue 0 is shared by all threads that are not pool workers.
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_queued;
+    std::atomic<int> m_idle;
+    std::atomic<bool> m_stop;
+};
+
+#endif // THREADPOOL_H
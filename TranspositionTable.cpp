@@ -0,0 +1,226 @@
+#include "TranspositionTable.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+// Data word layout:
+//   bits  0-7   depth + DEPTH_OFFSET, zero marks an empty slot
+//   bits  8-13  generation
+//   bits 14-15  bound          | bits 14-63 perft node count
+//   bits 16-31  move           |
+//   bits 32-47  score          |
+//   bits 48-63  static eval    |
+static const int DEPTH_OFFSET = 8;
+static const int GENERATION_SHIFT = 8;
+static const uint64_t GENERATION_MASK = 0x3F;
+static const int PAYLOAD_SHIFT = 14;
+static const uint64_t MAX_PERFT_NODES = (1ULL << (64 - PAYLOAD_SHIFT)) - 1;
+
+static int entryDepth(uint64_t data) { return static_cast<int>(data & 0xFF) - DEPTH_OFFSET; }
+static int entryGeneration(uint64_t data) { return static_cast<int>((data >> GENERATION_SHIFT) & GENERATION_MASK); }
+
+static std::atomic<int> nextCounterShard(0);
+static thread_local int counterShard = -1;
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+    : m_bucketCount(0), m_generation(0) {
+    resize(megabytes);
+    resetStats();
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    size_t count = (megabytes << 20) / sizeof(Bucket);
+    if (count == 0)
+        count = 1;
+    if (count != m_bucketCount) {
+        m_buckets.reset(new Bucket[count]);
+        m_bucketCount = count;
+    }
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < m_bucketCount; ++i) {
+        for (Entry& e : m_buckets[i].entries) {
+            e.keyXorData.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    m_generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+    m_generation = static_cast<uint8_t>((m_generation + 1) & GENERATION_MASK);
+}
+
+// Multiply-high maps the key onto any bucket count without a modulo.
+TranspositionTable::Bucket& TranspositionTable::bucketFor(uint64_t key) const {
+#if defined(__SIZEOF_INT128__)
+    size_t index = static_cast<size_t>((static_cast<unsigned __int128>(key) * m_bucketCount) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    size_t index = static_cast<size_t>(__umulh(key, m_bucketCount));
+#else
+    size_t index = static_cast<size_t>(key % m_bucketCount);
+#endif
+    return m_buckets[index];
+}
+
+TranspositionTable::Counters& TranspositionTable::counters() const {
+    if (counterShard < 0)
+        counterShard = nextCounterShard.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+    return m_counters[counterShard];
+}
+
+void TranspositionTable::prefetch(uint64_t key) const {
+#if defined(__GNUC__)
+    __builtin_prefetch(&bucketFor(key));
+#elif defined(__SSE__) || defined(_M_X64)
+    _mm_prefetch(reinterpret_cast<const char*>(&bucketFor(key)), _MM_HINT_T0);
+#endif
+}
+
+const TranspositionTable::Entry* TranspositionTable::find(uint64_t key, uint64_t& data) const {
+    const Bucket& bucket = bucketFor(key);
+    for (const Entry& e : bucket.entries) {
+        uint64_t d = e.data.load(std::memory_order_relaxed);
+        if (d != 0 && (e.keyXorData.load(std::memory_order_relaxed) ^ d) == key) {
+            data = d;
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& out) const {
+    Counters& c = counters();
+    c.probes.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t data;
+    if (!find(key, data))
+        return false;
+    c.hits.fetch_add(1, std::memory_order_relaxed);
+
+    out.depth = entryDepth(data);
+    out.bound = static_cast<Bound>((data >> 14) & 3);
+    out.move = Move::fromRaw(static_cast<uint16_t>(data >> 16));
+    out.score = static_cast<int16_t>(data >> 32);
+    out.eval = static_cast<int16_t>(data >> 48);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, Bound bound, int score, Move move, int eval) {
+    // Keep the old best move when this result did not produce one
+    uint64_t old;
+    if (move.isNull() && find(key, old))
+        move = Move::fromRaw(static_cast<uint16_t>(old >> 16));
+
+    uint64_t payload = static_cast<uint64_t>(bound)
+                     | static_cast<uint64_t>(move.raw()) << 2
+                     | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 18
+                     | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 34;
+    write(key, depth, payload);
+}
+
+bool TranspositionTable::probePerft(uint64_t key, int depth, uint64_t& nodes) const {
+    Counters& c = counters();
+    c.probes.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t data;
+    if (!find(key, data) || entryDepth(data) != depth)
+        return false;
+    c.hits.fetch_add(1, std::memory_order_relaxed);
+    nodes = data >> PAYLOAD_SHIFT;
+    return true;
+}
+
+void TranspositionTable::storePerft(uint64_t key, int depth, uint64_t nodes) {
+    if (nodes <= MAX_PERFT_NODES)
+        write(key, depth, nodes);
+}
+
+void TranspositionTable::write(uint64_t key, int depth, uint64_t payload) {
+    Bucket& bucket = bucketFor(key);
+    Entry* target = nullptr;
+    bool evicts = false;
+
+    // Same position: always refresh in place
+    for (Entry& e : bucket.entries) {
+        uint64_t d = e.data.load(std::memory_order_relaxed);
+        if (d != 0 && (e.keyXorData.load(std::memory_order_relaxed) ^ d) == key) {
+            target = &e;
+            break;
+        }
+    }
+
+    // Otherwise the shallowest of the depth-preferred slots, counting older
+    // generations as shallower; if even that one is deeper and current, fall
+    // back to the always-replace slot.
+    if (!target) {
+        int worst = 0;
+        int worstValue = 0;
+        for (int i = 0; i < BUCKET_SIZE - 1; ++i) {
+            uint64_t d = bucket.entries[i].data.load(std::memory_order_relaxed);
+            if (d == 0) {
+                worst = i;
+                worstValue = -1024;
+                break;
+            }
+            int age = (m_generation - entryGeneration(d)) & static_cast<int>(GENERATION_MASK);
+            int value = entryDepth(d) - 8 * age;
+            if (i == 0 || value < worstValue) {
+                worst = i;
+                worstValue = value;
+            }
+        }
+        target = (depth >= worstValue) ? &bucket.entries[worst] : &bucket.entries[BUCKET_SIZE - 1];
+        evicts = target->data.load(std::memory_order_relaxed) != 0;
+    }
+
+    uint64_t data = static_cast<uint64_t>(depth + DEPTH_OFFSET)
+                  | static_cast<uint64_t>(m_generation) << GENERATION_SHIFT
+                  | payload << PAYLOAD_SHIFT;
+    target->data.store(data, std::memory_order_relaxed);
+    target->keyXorData.store(key ^ data, std::memory_order_relaxed);
+
+    Counters& c = counters();
+    c.stores.fetch_add(1, std::memory_order_relaxed);
+    if (evicts)
+        c.replacements.fetch_add(1, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sample = m_bucketCount < 250 ? m_bucketCount : 250;
+    int used = 0;
+    for (size_t i = 0; i < sample; ++i) {
+        for (const Entry& e : m_buckets[i].entries) {
+            uint64_t d = e.data.load(std::memory_order_relaxed);
+            if (d != 0 && entryGeneration(d) == m_generation)
+                ++used;
+        }
+    }
+    return sample ? static_cast<int>(used * 1000 / (sample * BUCKET_SIZE)) : 0;
+}
+
+TTStats TranspositionTable::stats() const {
+    TTStats s = {0, 0, 0, 0};
+    for (const Counters& c : m_counters) {
+        s.probes += c.probes.load(std::memory_order_relaxed);
+        s.hits += c.hits.load(std::memory_order_relaxed);
+        s.stores += c.stores.load(std::memory_order_relaxed);
+        s.replacements += c.replacements.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void TranspositionTable::resetStats() {
+    for (Counters& c : m_counters) {
+        c.probes.store(0, std::memory_order_relaxed);
+        c.hits.store(0, std::memory_order_relaxed);
+        c.stores.store(0, std::memory_order_relaxed);
+        c.replacements.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+// Fixed-size hash table of search and perft results keyed by Zobrist key.
+//
+// Entries are two 64-bit words: the data and the key XORed with the data. A
+// reader accepts an entry only if the two words still XOR back to its key, so
+// a slot torn by a concurrent writer reads as a miss and no locks are needed.
+// Four entries share a 64-byte bucket: three keep the deepest results, the
+// fourth always takes what the others refuse.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Move.h"
+
+enum Bound : uint8_t {
+    BOUND_NONE = 0,
+    BOUND_UPPER = 1,
+    BOUND_LOWER = 2,
+    BOUND_EXACT = 3
+};
+
+// Unpacked view of a search entry.
+struct TTData {
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    Bound bound;
+};
+
+struct TTStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+    uint64_t replacements;   // stores that evicted a different position
+
+    double hitRate() const { return probes ? static_cast<double>(hits) / probes : 0.0; }
+};
+
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Reallocate and clear; not safe while other threads use the table.
+    void resize(size_t megabytes);
+    void clear();
+    size_t sizeMegabytes() const { return m_bucketCount * sizeof(Bucket) >> 20; }
+
+    // Age existing entries so a new search prefers to overwrite them.
+    void newSearch();
+
+    bool probe(uint64_t key, TTData& out) const;
+    void store(uint64_t key, int depth, Bound bound, int score, Move move, int eval);
+
+    // Perft subtree counts; an entry only answers for the depth it was stored at.
+    bool probePerft(uint64_t key, int depth, uint64_t& nodes) const;
+    void storePerft(uint64_t key, int depth, uint64_t nodes);
+
+    void prefetch(uint64_t key) const;
+
+    // Per mille of sampled entries written during the current search.
+    int hashfull() const;
+    TTStats stats() const;
+    void resetStats();
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    static const int BUCKET_SIZE = 4;
+
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    // Threads count into separate cache lines so statistics do not turn every
+    // probe into contended traffic; stats() adds the shards up.
+    static const int COUNTER_SHARDS = 16;
+
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> probes;
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> stores;
+        std::atomic<uint64_t> replacements;
+    };
+
+    Bucket& bucketFor(uint64_t key) const;
+    Counters& counters() const;
+    const Entry* find(uint64_t key, uint64_t& data) const;
+    void write(uint64_t key, int depth, uint64_t payload);
+
+    std::unique_ptr<Bucket[]> m_buckets;
+    size_t m_bucketCount;
+    uint8_t m_generation;
+    mutable Counters m_counters[COUNTER_SHARDS];
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -0,0 +1,44 @@
+#include "Zobrist.h"
+
+uint64_t zobristPiece[12][64];
+uint64_t zobristCastling[16];
+uint64_t zobristEpFile[8];
+uint64_t zobristSide;
+
+// splitmix64: well distributed output from a simple counter
+static uint64_t nextKey(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void initZobrist() {
+    uint64_t state = 1070372;
+
+    for (int pc = 0; pc < 12; ++pc)
+        for (int sq = 0; sq < 64; ++sq)
+            zobristPiece[pc][sq] = nextKey(state);
+
+    // Each right gets its own key; combinations are the XOR of their parts
+    uint64_t rightKeys[4];
+    for (int i = 0; i < 4; ++i)
+        rightKeys[i] = nextKey(state);
+    for (int rights = 0; rights < 16; ++rights) {
+        zobristCastling[rights] = 0;
+        for (int i = 0; i < 4; ++i)
+            if (rights & (1 << i))
+                zobristCastling[rights] ^= rightKeys[i];
+    }
+
+    for (int file = 0; file < 8; ++file)
+        zobristEpFile[file] = nextKey(state);
+
+    zobristSide = nextKey(state);
+}
+
+namespace {
+struct ZobristInit {
+    ZobristInit() { initZobrist(); }
+} zobristInit;
+}
@@ -0,0 +1,14 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+// Random keys for Zobrist position hashing, filled once at startup from a
+// fixed seed so keys are identical across runs and processes.
+
+#include <cstdint>
+
+extern uint64_t zobristPiece[12][64];
+extern uint64_t zobristCastling[16];
+extern uint64_t zobristEpFile[8];
+extern uint64_t zobristSide;
+
+#endif // ZOBRIST_H
@@ -0,0 +1,444 @@
+// chess_bench: micro-benchmarks for the headless rules core and the engine.
+//
+// Every heap allocation made while a benchmark loop runs is counted through the
+// replaced global operator new, and the process exits non-zero if a loop that
+// is meant to be allocation-free allocates, so CI can hold the count at zero.
+
+#include "Evaluate.h"
+#include "Move.h"
+#include "MoveGen.h"
+#include "PawnTable.h"
+#include "Pgn.h"
+#include "PgnIngest.h"
+#include "Position.h"
+#include "Search.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<long long> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Deterministic sample of positions reached by pseudo-random play from the start.
+static std::vector<Position> samplePositions(int count) {
+    std::vector<Position> positions;
+    positions.reserve(count);
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    Position pos;
+    pos.setStartPosition();
+
+    while (static_cast<int>(positions.size()) < count) {
+        MoveList moves;
+        generateLegalMoves(pos, moves);
+        if (moves.isEmpty() || pos.halfmoveClock() >= 100) {
+            pos.setStartPosition();
+            continue;
+        }
+        positions.push_back(pos);
+
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        pos.makeMove(moves[static_cast<int>(seed % moves.size())]);
+    }
+    return positions;
+}
+
+static bool benchMoveGen(int iterations) {
+    std::vector<Position> positions = samplePositions(1000);
+
+    long long before = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    long long total = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (const Position& pos : positions) {
+            MoveList moves;
+            generateLegalMoves(pos, moves);
+            total += moves.size();
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    long long allocations = allocationCount.load() - before;
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    long long calls = static_cast<long long>(iterations) * static_cast<long long>(positions.size());
+    std::printf("movegen: %lld calls, %lld moves, %.3f s, %.0f calls/s, %.0f moves/s\n",
+                calls, total, seconds, calls / seconds, total / seconds);
+    std::printf("movegen: allocations %lld\n", allocations);
+
+    return allocations == 0;
+}
+
+// FEN text of the sample positions packed into one buffer, as if read from a file
+static bool benchFen(int iterations) {
+    std::vector<Position> positions = samplePositions(1000);
+    std::string text;
+    std::vector<size_t> offsets;
+    for (const Position& pos : positions) {
+        char buf[MAX_FEN_LENGTH];
+        offsets.push_back(text.size());
+        text.append(buf, pos.toFen(buf));
+        text.push_back('\n');
+    }
+    offsets.push_back(text.size());
+
+    long long before = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    // Every parsed key must match the position it was written from
+    bool ok = true;
+    for (int i = 0; i < iterations; ++i) {
+        for (size_t j = 0; j < positions.size(); ++j) {
+            Position pos;
+            std::string_view fen(text.data() + offsets[j], offsets[j + 1] - offsets[j] - 1);
+            ok = pos.fromFen(fen).ok() && pos.key() == positions[j].key() && ok;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    long long calls = static_cast<long long>(iterations) * static_cast<long long>(positions.size());
+    double megabytes = static_cast<double>(iterations) * text.size() / (1 << 20);
+    std::printf("fen: parse %lld positions, %.3f s, %.0f positions/s, %.1f MB/s\n",
+                calls, seconds, calls / seconds, megabytes / seconds);
+
+    start = std::chrono::steady_clock::now();
+    size_t written = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (const Position& pos : positions) {
+            char buf[MAX_FEN_LENGTH];
+            written += pos.toFen(buf);
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("fen: write %lld positions, %.3f s, %.0f positions/s, %.1f MB/s\n",
+                calls, seconds, calls / seconds, written / seconds / (1 << 20));
+
+    long long allocations = allocationCount.load() - before;
+    std::printf("fen: round trip %s, allocations %lld\n", ok ? "ok" : "FAILED", allocations);
+    return ok && allocations == 0;
+}
+
+// PGN of pseudo-random games, cut at a typical game length, with the final
+// key of each for checking the replay
+static std::string sampleGames(int count, std::vector<uint64_t>& finalKeys) {
+    std::string text;
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    PgnGame game;
+    for (int g = 0; g < count; ++g) {
+        game.start.setStartPosition();
+        game.moves.clear();
+        Position pos = game.start;
+        for (int ply = 0; ply < 120; ++ply) {
+            MoveList moves;
+            generateLegalMoves(pos, moves);
+            if (moves.isEmpty() || pos.halfmoveClock() >= 100)
+                break;
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            Move m = moves[static_cast<int>(seed % moves.size())];
+            pos.makeMove(m);
+            game.moves.push_back(m);
+        }
+        game.result = "*";
+        writePgn(text, game);
+        finalKeys.push_back(pos.key());
+    }
+    return text;
+}
+
+// Parse and replay from a temporary file, the way a database is read
+static bool benchPgn(int games) {
+    std::vector<uint64_t> finalKeys;
+    std::string text = sampleGames(games, finalKeys);
+    std::FILE* file = std::tmpfile();
+    if (!file || std::fwrite(text.data(), 1, text.size(), file) != text.size()) {
+        std::fprintf(stderr, "pgn: cannot write temporary file\n");
+        return false;
+    }
+    std::rewind(file);
+
+    PgnReader reader(file);
+    PgnGame game;
+    long long before = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    bool ok = true;
+    uint64_t plies = 0;
+    while (reader.next(game)) {
+        uint64_t n = reader.gamesRead() - 1;
+        ok = game.ok() && n < finalKeys.size() && game.position.key() == finalKeys[n] && ok;
+        plies += game.moves.size();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    long long allocations = allocationCount.load() - before;
+    std::fclose(file);
+    ok = ok && reader.gamesRead() == finalKeys.size();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = static_cast<double>(text.size()) / (1 << 20);
+    std::printf("pgn: %llu games, %llu plies, %.1f MB, %.3f s, %.0f games/s, %.1f MB/s\n",
+                static_cast<unsigned long long>(reader.gamesRead()), static_cast<unsigned long long>(plies),
+                megabytes, seconds, reader.gamesRead() / seconds, megabytes / seconds);
+    // Only the first games grow the reused move and tag lists
+    std::printf("pgn: replay %s, allocations %lld\n", ok ? "ok" : "FAILED", allocations);
+    return ok;
+}
+
+// The pipeline over the same kind of file at growing worker counts; the
+// ordered sink checks every game's final key
+static bool benchIngest(int games) {
+    std::vector<uint64_t> finalKeys;
+    std::string text = sampleGames(games, finalKeys);
+    std::FILE* file = std::tmpfile();
+    if (!file || std::fwrite(text.data(), 1, text.size(), file) != text.size()) {
+        std::fprintf(stderr, "ingest: cannot write temporary file\n");
+        return false;
+    }
+
+    bool ok = true;
+    double baseline = 0;
+    double megabytes = static_cast<double>(text.size()) / (1 << 20);
+    for (int threads : {1, 2, 4, 8}) {
+        std::rewind(file);
+        PgnIngestOptions options;
+        options.threads = threads;
+        size_t next = 0;
+        bool passOk = true;
+
+        auto start = std::chrono::steady_clock::now();
+        PgnIngestStats stats = ingestPgn(file, options, [&](const PgnGameSummary& game) {
+            passOk = passOk && !game.error && next < finalKeys.size() && game.finalKey == finalKeys[next];
+            ++next;
+        });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        passOk = passOk && stats.games == finalKeys.size() && !stats.failed;
+        ok = ok && passOk;
+
+        if (threads == 1)
+            baseline = seconds;
+        std::printf("ingest: %2d threads, %llu games, %.3f s, %.0f games/s, %.1f MB/s, speedup %.2f%s\n",
+                    threads, static_cast<unsigned long long>(stats.games), seconds, stats.games / seconds,
+                    megabytes / seconds, baseline / seconds, passOk ? "" : ", FAILED");
+    }
+    std::fclose(file);
+    std::printf("ingest: %d hardware threads\n", ThreadPool::hardwareThreads());
+    return ok;
+}
+
+static bool benchEval(int iterations) {
+    std::vector<Position> positions = samplePositions(1000);
+
+    long long before = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    // The sum keeps the calls from being optimised away
+    long long total = 0;
+    for (int i = 0; i < iterations; ++i)
+        for (const Position& pos : positions)
+            total += evaluate(pos);
+
+    auto end = std::chrono::steady_clock::now();
+    long long allocations = allocationCount.load() - before;
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    long long calls = static_cast<long long>(iterations) * static_cast<long long>(positions.size());
+    std::printf("eval: %lld calls, %.3f s, %.1f ns/call, checksum %lld\n",
+                calls, seconds, seconds * 1e9 / calls, total);
+    std::printf("eval: allocations %lld\n", allocations);
+
+    // After the first pass every structure is cached, so this is the cost of a
+    // hit; the search benchmark reports the hit rate of real searches
+    PawnTable pawns;
+    before = allocationCount.load();
+    start = std::chrono::steady_clock::now();
+    long long cachedTotal = 0;
+    for (int i = 0; i < iterations; ++i)
+        for (const Position& pos : positions)
+            cachedTotal += evaluate(pos, pawns);
+    end = std::chrono::steady_clock::now();
+    allocations += allocationCount.load() - before;
+    seconds = std::chrono::duration<double>(end - start).count();
+    PawnTableStats pawnStats = pawns.stats();
+    std::printf("eval: pawn hash %.3f s, %.1f ns/call, hit rate %.1f%%, checksum %lld\n",
+                seconds, seconds * 1e9 / calls, 100.0 * pawnStats.hitRate(), cachedTotal);
+
+    // The incrementally kept part alone: material and piece-square tables, tapered
+    start = std::chrono::steady_clock::now();
+    long long psqTotal = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (const Position& pos : positions) {
+            Score s = pos.psqScore();
+            int phase = pos.gamePhase();
+            psqTotal += (mgValue(s) * phase + egValue(s) * (PHASE_MAX - phase)) / PHASE_MAX;
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("eval: psq only %.3f s, %.1f ns/call, checksum %lld\n", seconds, seconds * 1e9 / calls, psqTotal);
+
+    return allocations == 0;
+}
+
+// Middlegame and endgame positions searched to a fixed depth from a cleared
+// table, so node counts are reproducible and runs are comparable.
+static const char* searchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "2r3k1/pp3ppp/4p3/3pP3/3P4/P4N2/1P3PPP/2R3K1 w - - 0 25",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+static bool benchSearch(int depth) {
+    TranspositionTable tt(16);
+    Search search(tt);
+    SearchLimits limits;
+    limits.depth = depth;
+
+    uint64_t totalNodes = 0;
+    int64_t totalMs = 0;
+    uint64_t pawnHits = 0;
+    uint64_t pawnProbes = 0;
+    for (const char* fen : searchPositions) {
+        Position pos;
+        pos.setFromFen(fen);
+        tt.clear();
+        search.clear();
+
+        SearchResult result = search.run(pos, limits);
+        totalNodes += result.nodes;
+        totalMs += result.timeMs;
+
+        PawnTableStats pawnStats = search.pawnHashStats();
+        pawnHits += pawnStats.hits;
+        pawnProbes += pawnStats.hits + pawnStats.misses;
+
+        char uci[6];
+        moveToUci(result.bestMove, uci);
+        std::printf("search: depth %d bestmove %-5s score %6d nodes %10llu %6lld ms\n", result.depth, uci,
+                    result.score, static_cast<unsigned long long>(result.nodes), static_cast<long long>(result.timeMs));
+    }
+
+    double seconds = totalMs / 1000.0;
+    std::printf("search: %llu nodes, %.3f s, %.0f nps, pawn hash hit rate %.1f%%\n",
+                static_cast<unsigned long long>(totalNodes), seconds, seconds > 0 ? totalNodes / seconds : 0.0,
+                pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0);
+    return true;
+}
+
+// Time-to-depth of the Lazy SMP search for growing thread counts. Each run
+// starts from a cleared table, and speedup is relative to the single thread.
+static bool benchSmp(int depth) {
+    static const int threadCounts[] = {1, 2, 4, 8, 16};
+    TranspositionTable tt(64);
+    SearchLimits limits;
+    limits.depth = depth;
+
+    double baseSeconds = 0;
+    for (int threads : threadCounts) {
+        Search search(tt, threads);
+        uint64_t totalNodes = 0;
+        int64_t totalMs = 0;
+        for (const char* fen : searchPositions) {
+            Position pos;
+            pos.setFromFen(fen);
+            tt.clear();
+
+            SearchResult result = search.run(pos, limits);
+            totalNodes += result.nodes;
+            totalMs += result.timeMs;
+        }
+
+        double seconds = totalMs / 1000.0;
+        if (threads == 1)
+            baseSeconds = seconds;
+        std::printf("smp: threads %2d depth %d nodes %11llu %8.3f s %10.0f nps speedup %.2f\n", threads, depth,
+                    static_cast<unsigned long long>(totalNodes), seconds, seconds > 0 ? totalNodes / seconds : 0.0,
+                    seconds > 0 ? baseSeconds / seconds : 0.0);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* which = argc > 1 ? argv[1] : "all";
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 0;
+    bool all = !std::strcmp(which, "all");
+    bool ran = false;
+    bool ok = true;
+
+    if (all || !std::strcmp(which, "movegen")) {
+        ok = benchMoveGen(iterations > 0 ? iterations : 200) && ok;
+        ran = true;
+    }
+
+    if (all || !std::strcmp(which, "fen")) {
+        ok = benchFen(iterations > 0 ? iterations : 2000) && ok;
+        ran = true;
+    }
+
+    if (all || !std::strcmp(which, "pgn")) {
+        ok = benchPgn(iterations > 0 ? iterations : 20000) && ok;
+        ran = true;
+    }
+
+    if (all || !std::strcmp(which, "eval")) {
+        ok = benchEval(iterations > 0 ? iterations : 2000) && ok;
+        ran = true;
+    }
+
+    // For the search benchmark the second argument is the depth
+    if (all || !std::strcmp(which, "search")) {
+        ok = benchSearch(iterations > 0 ? iterations : 9) && ok;
+        ran = true;
+    }
+
+    // Not part of "all": these run their whole workload once per thread count
+    if (!std::strcmp(which, "ingest")) {
+        ok = benchIngest(iterations > 0 ? iterations : 20000) && ok;
+        ran = true;
+    }
+
+    if (!std::strcmp(which, "smp")) {
+        ok = benchSmp(iterations > 0 ? iterations : 10) && ok;
+        ran = true;
+    }
+
+    if (!ran) {
+        std::fprintf(stderr, "usage: chess_bench [all|movegen|fen|pgn|eval|search|ingest|smp] [iterations|depth]\n");
+        return EXIT_FAILURE;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,174 @@
+// chess_gamedb: convert PGN to the compact binary game format and read it back.
+//
+//   chess_gamedb convert <in.pgn|-> <out> [--positions]
+//                                        replay every PGN game and store its
+//                                        moves and result; --positions also
+//                                        stores every position the games reach
+//   chess_gamedb info <file>             print counts and sizes
+//   chess_gamedb show <file> <n>         print game n as PGN
+//   chess_gamedb scan <file>             decode every game and print throughput
+//
+// Games that do not replay are left out of the output and counted. Tags are
+// not kept: the format holds only what is needed to rebuild the positions.
+
+#include "GameFile.h"
+#include "Pgn.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static void printUsage() {
+    std::fprintf(stderr, "usage: chess_gamedb convert <in.pgn|-> <out> [--positions]\n"
+                         "       chess_gamedb info <file>\n"
+                         "       chess_gamedb show <file> <n>\n"
+                         "       chess_gamedb scan <file>\n");
+}
+
+static int convert(const char* in, const char* out, bool positions) {
+    std::FILE* file = std::strcmp(in, "-") ? std::fopen(in, "rb") : stdin;
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", in);
+        return EXIT_FAILURE;
+    }
+    GameFileWriter writer;
+    if (!writer.open(out)) {
+        std::fprintf(stderr, "cannot create %s\n", out);
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    PgnReader reader(file);
+    PgnGame game;
+    uint64_t skipped = 0;
+    while (reader.next(game)) {
+        if (!game.ok() || !writer.addGame(game.start, game.moves, parseResult(game.result))) {
+            ++skipped;
+            continue;
+        }
+        if (positions) {
+            Position pos = game.start;
+            writer.addPosition(pos);
+            for (Move m : game.moves) {
+                pos.makeMove(m);
+                writer.addPosition(pos);
+            }
+        }
+    }
+    bool readError = reader.readError();
+    uint64_t bytes = reader.bytesRead();
+    if (file != stdin)
+        std::fclose(file);
+    uint64_t games = writer.gameCount();
+    uint64_t positionCount = writer.positionCount();
+    if (!writer.close() || readError) {
+        std::fprintf(stderr, "error %s\n", readError ? "reading the input" : "writing the output");
+        return EXIT_FAILURE;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%llu games, %llu skipped, %llu positions, %.1f MB read, %.3f s\n",
+                static_cast<unsigned long long>(games), static_cast<unsigned long long>(skipped),
+                static_cast<unsigned long long>(positionCount), static_cast<double>(bytes) / (1 << 20), seconds);
+    return skipped ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static bool openFile(GameFile& file, const char* path) {
+    if (file.open(path))
+        return true;
+    std::fprintf(stderr, "%s is not a readable game file\n", path);
+    return false;
+}
+
+static int info(const char* path) {
+    GameFile file;
+    if (!openFile(file, path))
+        return EXIT_FAILURE;
+    std::FILE* f = std::fopen(path, "rb");
+    long size = 0;
+    if (f && std::fseek(f, 0, SEEK_END) == 0)
+        size = std::ftell(f);
+    if (f)
+        std::fclose(f);
+    std::printf("%llu games, %llu positions, %ld bytes", static_cast<unsigned long long>(file.gameCount()),
+                static_cast<unsigned long long>(file.positionCount()), size);
+    if (file.gameCount())
+        std::printf(", %.1f bytes per game", static_cast<double>(size) / file.gameCount());
+    std::printf("\n");
+    return EXIT_SUCCESS;
+}
+
+static int show(const char* path, const char* index) {
+    GameFile file;
+    if (!openFile(file, path))
+        return EXIT_FAILURE;
+    GameRecord record;
+    uint64_t n = std::strtoull(index, nullptr, 10);
+    if (!file.readGame(n, record)) {
+        std::fprintf(stderr, "no valid game %llu\n", static_cast<unsigned long long>(n));
+        return EXIT_FAILURE;
+    }
+
+    PgnGame game;
+    game.start = record.start;
+    game.moves = record.moves;
+    game.position = record.position;
+    game.result = resultText(record.result);
+    std::string out;
+    writePgn(out, game);
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    return EXIT_SUCCESS;
+}
+
+static int scan(const char* path) {
+    GameFile file;
+    if (!openFile(file, path))
+        return EXIT_FAILURE;
+
+    auto start = std::chrono::steady_clock::now();
+
+    GameRecord record;
+    uint64_t plies = 0;
+    uint64_t failed = 0;
+    uint64_t checksum = 0;
+    for (uint64_t i = 0; i < file.gameCount(); ++i) {
+        if (!file.readGame(i, record)) {
+            ++failed;
+            continue;
+        }
+        plies += record.moves.size();
+        checksum ^= record.position.key();
+    }
+    Position pos;
+    for (uint64_t i = 0; i < file.positionCount(); ++i) {
+        if (!file.readPosition(i, pos))
+            ++failed;
+        checksum ^= pos.key();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t games = file.gameCount();
+    std::printf("%llu games, %llu plies, %llu positions, %llu corrupt, checksum %016llx\n",
+                static_cast<unsigned long long>(games), static_cast<unsigned long long>(plies),
+                static_cast<unsigned long long>(file.positionCount()), static_cast<unsigned long long>(failed),
+                static_cast<unsigned long long>(checksum));
+    std::printf("%.3f s, %.0f games/s, %.0f plies/s\n", seconds, seconds > 0 ? games / seconds : 0.0,
+                seconds > 0 ? plies / seconds : 0.0);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && !std::strcmp(argv[1], "convert"))
+        return convert(argv[2], argv[3], argc >= 5 && !std::strcmp(argv[4], "--positions"));
+    if (argc >= 3 && !std::strcmp(argv[1], "info"))
+        return info(argv[2]);
+    if (argc >= 4 && !std::strcmp(argv[1], "show"))
+        return show(argv[2], argv[3]);
+    if (argc >= 3 && !std::strcmp(argv[1], "scan"))
+        return scan(argv[2]);
+    printUsage();
+    return EXIT_FAILURE;
+}
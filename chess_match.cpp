@@ -0,0 +1,566 @@
+// chess_match: play engine-vs-engine games concurrently and decide between
+// the engines with Elo and a sequential probability ratio test.
+//
+//   chess_match --engine <path> [--engine <path>] [options]
+//
+// Each engine is a UCI program such as chess_uci; with one engine it plays
+// itself. Every game starts two fresh engine processes, so games share
+// nothing, and the games run as tasks on a pool of --concurrency threads
+// (default: all hardware threads). Only one side of a game thinks at a
+// time, so that keeps every core busy.
+//
+//   --openings <file>   FEN or EPD lines, one per line; each opening is
+//                       played twice with the colours swapped. Without a
+//                       file every game starts from the standard position.
+//   --games N           games to play (default 100)
+//   --tc B+I            base time and increment in seconds (default 10+0.1)
+//   --hash MB           hash per engine (default 16)
+//   --pgn <file>        append every game to a PGN file as it finishes
+//   --sprt E0 E1        stop once the test accepts elo E0 or elo E1
+//   --alpha A, --beta B error rates of the test (default 0.05 each)
+//
+// Games end by the rules, including every draw by rule, or when a side
+// runs out of time (a draw if the other side cannot mate), plays an
+// illegal move or dies. Results count for the
+// first engine; after each game the running Elo estimate, its 95% error
+// margin and the test's log-likelihood ratio are printed.
+
+#include "Draw.h"
+#include "GameFile.h"
+#include "MoveGen.h"
+#include "Pgn.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+static void printUsage() {
+    std::fprintf(stderr, "usage: chess_match --engine <path> [--engine <path>] [--openings <file>] [--games N]\n"
+                         "                   [--concurrency N] [--tc B+I] [--hash MB] [--pgn <file>]\n"
+                         "                   [--sprt E0 E1] [--alpha A] [--beta B]\n");
+}
+
+// A UCI engine running as a child process, talked to over pipes.
+class EngineProcess {
+public:
+    enum ReadStatus { LINE, TIMEOUT, CLOSED };
+
+    EngineProcess() : m_pid(-1), m_in(-1), m_out(-1) {}
+    ~EngineProcess() { close(); }
+
+    EngineProcess(const EngineProcess&) = delete;
+    EngineProcess& operator=(const EngineProcess&) = delete;
+
+    bool start(const std::string& path);
+    void close();
+
+    bool send(const std::string& line);
+    // Next line from the engine, waiting at most timeoutMs
+    ReadStatus readLine(std::string& line, int64_t timeoutMs);
+    // Read up to the line starting with prefix
+    bool waitFor(const char* prefix, int64_t timeoutMs, std::string& line);
+
+private:
+    pid_t m_pid;
+    int m_in;       // engine's stdin
+    int m_out;      // engine's stdout
+    std::string m_buffer;
+};
+
+bool EngineProcess::start(const std::string& path) {
+    // Close-on-exec, so engines of other games started meanwhile do not
+    // hold these pipes open
+    int toEngine[2], fromEngine[2];
+    if (pipe2(toEngine, O_CLOEXEC))
+        return false;
+    if (pipe2(fromEngine, O_CLOEXEC)) {
+        ::close(toEngine[0]);
+        ::close(toEngine[1]);
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, toEngine[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fromEngine[1], STDOUT_FILENO);
+    char* argv[] = {const_cast<char*>(path.c_str()), nullptr};
+    int error = posix_spawnp(&m_pid, path.c_str(), &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    ::close(toEngine[0]);
+    ::close(fromEngine[1]);
+    m_in = toEngine[1];
+    m_out = fromEngine[0];
+    if (error) {
+        m_pid = -1;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void EngineProcess::close() {
+    if (m_in >= 0) {
+        send("quit");
+        ::close(m_in);
+        m_in = -1;
+    }
+    if (m_pid > 0) {
+        // Give the engine a moment to leave on its own
+        int status;
+        bool exited = false;
+        for (int i = 0; i < 50 && !exited; ++i) {
+            exited = waitpid(m_pid, &status, WNOHANG) == m_pid;
+            if (!exited)
+                usleep(2000);
+        }
+        if (!exited) {
+            kill(m_pid, SIGKILL);
+            waitpid(m_pid, &status, 0);
+        }
+        m_pid = -1;
+    }
+    if (m_out >= 0) {
+        ::close(m_out);
+        m_out = -1;
+    }
+    m_buffer.clear();
+}
+
+bool EngineProcess::send(const std::string& line) {
+    if (m_in < 0)
+        return false;
+    std::string data = line + '\n';
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(m_in, data.data() + done, data.size() - done);
+        if (n <= 0)
+            return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+EngineProcess::ReadStatus EngineProcess::readLine(std::string& line, int64_t timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        size_t end = m_buffer.find('\n');
+        if (end != std::string::npos) {
+            line.assign(m_buffer, 0, end);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            m_buffer.erase(0, end + 1);
+            return LINE;
+        }
+        if (m_out < 0)
+            return CLOSED;
+
+        int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+            return TIMEOUT;
+        pollfd fd = {m_out, POLLIN, 0};
+        if (poll(&fd, 1, static_cast<int>(std::min<int64_t>(left, 1 << 30))) <= 0)
+            continue;
+
+        char chunk[4096];
+        ssize_t n = read(m_out, chunk, sizeof(chunk));
+        if (n <= 0)
+            return CLOSED;
+        m_buffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+bool EngineProcess::waitFor(const char* prefix, int64_t timeoutMs, std::string& line) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           deadline - std::chrono::steady_clock::now()).count();
+        if (readLine(line, std::max<int64_t>(left, 0)) != LINE)
+            return false;
+        if (line.compare(0, std::strlen(prefix), prefix) == 0)
+            return true;
+    }
+}
+
+struct MatchOptions {
+    std::vector<std::string> engines;
+    std::vector<std::string> openings;    // FEN strings
+    int games = 100;
+    int concurrency = 0;
+    double baseSeconds = 10;
+    double incrementSeconds = 0.1;
+    int hashMb = 16;
+    const char* pgnPath = nullptr;
+    bool sprt = false;
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+// How a game ended, as the PGN Termination tag puts it
+struct GameOutcome {
+    GameResult result;
+    const char* termination;
+    const char* reason;
+};
+
+// Engines need a few seconds at most to start and answer isready
+const int64_t HANDSHAKE_MS = 10000;
+
+static bool startEngine(EngineProcess& engine, const std::string& path, int hashMb, std::string& name) {
+    std::string line;
+    if (!engine.start(path) || !engine.send("uci"))
+        return false;
+    name = path.substr(path.find_last_of('/') + 1);
+    for (;;) {
+        if (engine.readLine(line, HANDSHAKE_MS) != EngineProcess::LINE)
+            return false;
+        if (line.compare(0, 8, "id name ") == 0)
+            name = line.substr(8);
+        else if (line == "uciok")
+            break;
+    }
+    engine.send("setoption name Hash value " + std::to_string(hashMb));
+    engine.send("setoption name Threads value 1");
+    engine.send("ucinewgame");
+    engine.send("isready");
+    return engine.waitFor("readyok", HANDSHAKE_MS, line);
+}
+
+static GameOutcome loss(Color side, const char* termination, const char* reason) {
+    return {side == WHITE ? BLACK_WINS : WHITE_WINS, termination, reason};
+}
+
+// Play one game from start with paths[0] as White; the moves go to game.
+static GameOutcome playGame(const MatchOptions& options, const std::string paths[COLOR_NB],
+                            const std::string& startFen, PgnGame& game, std::string names[COLOR_NB]) {
+    EngineProcess engines[COLOR_NB];
+    for (Color c : {WHITE, BLACK})
+        if (!startEngine(engines[c], paths[c], options.hashMb, names[c]))
+            return loss(c, "abandoned", "engine failed to start");
+
+    Position pos = game.start;
+    RepetitionHistory keys;
+    keys.reset(pos.key());
+
+    int64_t clockMs[COLOR_NB];
+    int64_t incrementMs = static_cast<int64_t>(options.incrementSeconds * 1000);
+    clockMs[WHITE] = clockMs[BLACK] = static_cast<int64_t>(options.baseSeconds * 1000);
+
+    std::string position = "position fen " + startFen + " moves";
+    std::string line;
+    for (;;) {
+        MoveList legal;
+        generateLegalMoves(pos, legal);
+        if (legal.isEmpty() && pos.inCheck())
+            return loss(pos.sideToMove(), "normal", "checkmate");
+        DrawReason draw = drawReason(pos, keys);
+        if (draw != NO_DRAW)
+            return {DRAW, "normal", drawReasonName(draw)};
+
+        Color us = pos.sideToMove();
+        EngineProcess& engine = engines[us];
+        engine.send(position);
+        engine.send("go wtime " + std::to_string(clockMs[WHITE]) + " btime " + std::to_string(clockMs[BLACK])
+                    + " winc " + std::to_string(incrementMs) + " binc " + std::to_string(incrementMs));
+
+        auto start = std::chrono::steady_clock::now();
+        bool answered = false;
+        for (;;) {
+            int64_t left = clockMs[us] - std::chrono::duration_cast<std::chrono::milliseconds>(
+                                             std::chrono::steady_clock::now() - start).count();
+            EngineProcess::ReadStatus status = engine.readLine(line, std::max<int64_t>(left, 0) + 1);
+            if (status == EngineProcess::CLOSED)
+                return loss(us, "abandoned", "engine died");
+            if (status == EngineProcess::TIMEOUT)
+                break;
+            if (line.compare(0, 9, "bestmove ") == 0) {
+                answered = true;
+                break;
+            }
+        }
+        clockMs[us] -= std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start).count();
+        if (!answered || clockMs[us] < 0) {
+            // Running out of time only loses to a side that could still mate
+            if (!hasMatingMaterial(pos, ~us))
+                return {DRAW, "time forfeit", "out of time against no mating material"};
+            return loss(us, "time forfeit", "out of time");
+        }
+        clockMs[us] += incrementMs;
+
+        std::string text = line.substr(9, line.find(' ', 9) - 9);
+        Move move;
+        for (Move m : legal) {
+            char uci[6];
+            moveToUci(m, uci);
+            if (text == uci)
+                move = m;
+        }
+        if (move.isNull())
+            return loss(us, "rules infraction", "illegal move");
+
+        pos.makeMove(move);
+        keys.push(pos.key());
+        game.moves.push_back(move);
+        position += ' ' + text;
+    }
+}
+
+// Wins, draws and losses of the first engine, and what they say
+struct MatchScore {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const { return games() ? (wins + draws * 0.5) / games() : 0.5; }
+    // Per-game variance of the score
+    double variance() const {
+        double s = score();
+        return games() ? (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games() : 0;
+    }
+};
+
+static double eloFromScore(double score) {
+    score = std::clamp(score, 1e-6, 1 - 1e-6);
+    return -400 * std::log10(1 / score - 1);
+}
+
+static double scoreFromElo(double elo) {
+    return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+// Half the width of the 95% interval around the Elo estimate
+static double eloMargin(const MatchScore& m) {
+    if (m.games() == 0)
+        return 0;
+    double deviation = std::sqrt(m.variance() / m.games());
+    return (eloFromScore(m.score() + 1.96 * deviation) - eloFromScore(m.score() - 1.96 * deviation)) / 2;
+}
+
+// Log-likelihood ratio of elo1 against elo0 in the normal approximation of
+// the trinomial model
+static double sprtLlr(const MatchScore& m, double elo0, double elo1) {
+    double variance = m.variance();
+    if (m.games() == 0 || variance <= 0)
+        return 0;
+    double s0 = scoreFromElo(elo0);
+    double s1 = scoreFromElo(elo1);
+    return m.games() * (s1 - s0) * (2 * m.score() - s0 - s1) / (2 * variance);
+}
+
+// Lines of the openings file that parse as FEN or EPD; EPD operations after
+// the fourth field are dropped
+static bool readOpenings(const char* path, std::vector<std::string>& openings) {
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file)
+        return false;
+    char buffer[1024];
+    while (std::fgets(buffer, sizeof(buffer), file)) {
+        std::vector<std::string> fields;
+        for (char* token = std::strtok(buffer, " \t\r\n"); token && fields.size() < 6;
+             token = std::strtok(nullptr, " \t\r\n"))
+            fields.push_back(token);
+        if (fields.size() < 4)
+            continue;
+        // Move clocks only when both are numbers
+        size_t used = 4;
+        if (fields.size() == 6 && std::isdigit(static_cast<unsigned char>(fields[4][0]))
+            && std::isdigit(static_cast<unsigned char>(fields[5][0])))
+            used = 6;
+        std::string fen = fields[0];
+        for (size_t i = 1; i < used; ++i)
+            fen += ' ' + fields[i];
+        Position pos;
+        if (pos.fromFen(fen).ok())
+            openings.push_back(fen);
+    }
+    std::fclose(file);
+    return true;
+}
+
+static bool parseTimeControl(const char* text, MatchOptions& options) {
+    char* end;
+    options.baseSeconds = std::strtod(text, &end);
+    options.incrementSeconds = 0;
+    if (*end == '+')
+        options.incrementSeconds = std::strtod(end + 1, &end);
+    return *end == '\0' && options.baseSeconds > 0 && options.incrementSeconds >= 0;
+}
+
+static int runMatch(const MatchOptions& options) {
+    std::FILE* pgn = nullptr;
+    if (options.pgnPath && !(pgn = std::fopen(options.pgnPath, "ab"))) {
+        std::fprintf(stderr, "cannot open %s\n", options.pgnPath);
+        return EXIT_FAILURE;
+    }
+
+    char date[16];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+    char timeControl[64];
+    std::snprintf(timeControl, sizeof(timeControl), "%g+%g", options.baseSeconds, options.incrementSeconds);
+
+    std::vector<std::string> openings = options.openings;
+    if (openings.empty())
+        openings.push_back("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    const std::string& first = options.engines[0];
+    const std::string& second = options.engines.size() > 1 ? options.engines[1] : options.engines[0];
+
+    double lowerBound = std::log(options.beta / (1 - options.alpha));
+    double upperBound = std::log((1 - options.beta) / options.alpha);
+
+    // Results arrive from the pool threads; this guards the score, the
+    // output and the PGN file
+    std::mutex mutex;
+    MatchScore score;
+    std::atomic<bool> decided(false);
+    auto start = std::chrono::steady_clock::now();
+
+    ThreadPool pool(options.concurrency);
+    TaskGroup group;
+    for (int index = 0; index < options.games; ++index) {
+        pool.submit(group, [&, index] {
+            if (decided.load(std::memory_order_relaxed))
+                return;
+
+            // Each opening twice, the first engine White in the first game
+            bool firstIsWhite = index % 2 == 0;
+            const std::string& fen = openings[(index / 2) % openings.size()];
+            std::string paths[COLOR_NB] = {firstIsWhite ? first : second, firstIsWhite ? second : first};
+            std::string names[COLOR_NB] = {paths[WHITE], paths[BLACK]};
+
+            PgnGame game;
+            game.start.fromFen(fen);
+            GameOutcome outcome = playGame(options, paths, fen, game, names);
+            // Two builds of one engine answer to the same name
+            if (names[WHITE] == names[BLACK] && paths[WHITE] != paths[BLACK]) {
+                names[WHITE] = paths[WHITE];
+                names[BLACK] = paths[BLACK];
+            }
+            game.result = resultText(outcome.result);
+
+            std::string round = std::to_string(index + 1);
+            std::string text;
+            game.tags = {{"Event", "chess_match"}, {"Date", date}, {"Round", round}, {"White", names[WHITE]},
+                         {"Black", names[BLACK]}, {"TimeControl", timeControl},
+                         {"Termination", outcome.termination}};
+            writePgn(text, game);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pgn) {
+                std::fwrite(text.data(), 1, text.size(), pgn);
+                std::fflush(pgn);
+            }
+            bool firstWon = (outcome.result == WHITE_WINS) == firstIsWhite;
+            if (outcome.result == DRAW)
+                ++score.draws;
+            else if (firstWon)
+                ++score.wins;
+            else
+                ++score.losses;
+
+            std::printf("game %d: %s vs %s %.*s, %s; %d-%d-%d, elo %+.1f +/- %.1f", index + 1,
+                        names[WHITE].c_str(), names[BLACK].c_str(), static_cast<int>(game.result.size()),
+                        game.result.data(), outcome.reason, score.wins, score.losses, score.draws,
+                        eloFromScore(score.score()), eloMargin(score));
+            if (options.sprt) {
+                double llr = sprtLlr(score, options.elo0, options.elo1);
+                std::printf(", llr %.2f (%.2f, %.2f)", llr, lowerBound, upperBound);
+                if (llr <= lowerBound || llr >= upperBound)
+                    decided.store(true, std::memory_order_relaxed);
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        });
+    }
+    pool.wait(group);
+    if (pgn)
+        std::fclose(pgn);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%d games, %d-%d-%d (wins-losses-draws of %s), score %.1f%%, elo %+.1f +/- %.1f, %.1f s\n",
+                score.games(), score.wins, score.losses, score.draws, first.c_str(), 100 * score.score(),
+                eloFromScore(score.score()), eloMargin(score), seconds);
+    if (options.sprt) {
+        double llr = sprtLlr(score, options.elo0, options.elo1);
+        const char* verdict = llr >= upperBound ? "H1 accepted" : llr <= lowerBound ? "H0 accepted" : "inconclusive";
+        std::printf("sprt elo0 %g elo1 %g alpha %g beta %g: llr %.2f (%.2f, %.2f), %s\n", options.elo0,
+                    options.elo1, options.alpha, options.beta, llr, lowerBound, upperBound, verdict);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    MatchOptions options;
+    options.concurrency = ThreadPool::hardwareThreads();
+    const char* openingsPath = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--engine") && hasValue) {
+            options.engines.push_back(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--openings") && hasValue) {
+            openingsPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--games") && hasValue) {
+            options.games = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--concurrency") && hasValue) {
+            options.concurrency = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--tc") && hasValue) {
+            if (!parseTimeControl(argv[++i], options)) {
+                std::fprintf(stderr, "bad time control %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (!std::strcmp(argv[i], "--hash") && hasValue) {
+            options.hashMb = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--pgn") && hasValue) {
+            options.pgnPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--sprt") && i + 2 < argc) {
+            options.sprt = true;
+            options.elo0 = std::atof(argv[++i]);
+            options.elo1 = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--alpha") && hasValue) {
+            options.alpha = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--beta") && hasValue) {
+            options.beta = std::atof(argv[++i]);
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.engines.empty() || options.engines.size() > 2 || options.games <= 0) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    if (openingsPath && (!readOpenings(openingsPath, options.openings) || options.openings.empty())) {
+        std::fprintf(stderr, "no openings read from %s\n", openingsPath);
+        return EXIT_FAILURE;
+    }
+
+    // A dead engine must not take the match down with it
+    std::signal(SIGPIPE, SIG_IGN);
+    return runMatch(options);
+}
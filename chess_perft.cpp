@@ -0,0 +1,321 @@
+// chess_perft: count legal move tree leaves to verify and time the rules core.
+//
+//   chess_perft <depth> [fen]             total node count and nodes per second
+//   chess_perft divide <depth> [fen]      node count below each root move
+//   chess_perft suite [--min-nps N]       reference positions with known counts;
+//                                         exits non-zero on any mismatch or if the
+//                                         overall speed falls below N nodes/s
+//   chess_perft epd <file> [--max-depth D]
+//                                         verify every "fen ;D1 n ;D2 n ..." line,
+//                                         one position per pool task
+//
+// Every mode accepts --threads N (default: all hardware threads) and
+// --hash MB, which caches subtree counts in a shared transposition table.
+
+#include "MoveGen.h"
+#include "Perft.h"
+#include "Position.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+};
+
+// Standard positions from the chess programming community, plus small
+// positions that isolate en-passant, castling and promotion edge cases.
+static const PerftCase referenceSuite[] = {
+    {"initial", START_FEN, 5, 4865609ULL},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083ULL},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ULL},
+    {"position4-mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292ULL},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ULL},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL},
+    {"ep-illegal-pin", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888ULL},
+    {"ep-illegal-diagonal", "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1015133ULL},
+    {"ep-gives-check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467ULL},
+    {"castle-gives-check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072ULL},
+    {"long-castle-gives-check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711ULL},
+    {"castle-rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206ULL},
+    {"castle-prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476ULL},
+    {"promote-out-of-check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001ULL},
+    {"discovered-check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658ULL},
+    {"promote-gives-check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342ULL},
+    {"underpromote-gives-check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683ULL},
+    {"self-stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217ULL},
+    {"stalemate-checkmate", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584ULL},
+    {"double-check", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527ULL},
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// FENs contain spaces; accept them either quoted or spread over several arguments.
+static std::string joinArgs(const std::vector<std::string>& args, size_t first) {
+    std::string fen;
+    for (size_t i = first; i < args.size(); ++i) {
+        if (!fen.empty())
+            fen += ' ';
+        fen += args[i];
+    }
+    return fen.empty() ? std::string(START_FEN) : fen;
+}
+
+static bool loadPosition(Position& pos, const std::string& fen) {
+    FenError error = pos.fromFen(fen);
+    if (!error.ok()) {
+        std::fprintf(stderr, "invalid FEN: %s\n  %s\n  %*s^\n", error.message, fen.c_str(),
+                     static_cast<int>(error.offset), "");
+        return false;
+    }
+    return true;
+}
+
+static void printHashStats(const TranspositionTable* tt) {
+    if (!tt)
+        return;
+    TTStats s = tt->stats();
+    std::printf("hash: %zu MB, %llu probes, %.1f%% hits, %llu stores, %llu replacements, %d permille full\n",
+                tt->sizeMegabytes(), static_cast<unsigned long long>(s.probes), 100.0 * s.hitRate(),
+                static_cast<unsigned long long>(s.stores), static_cast<unsigned long long>(s.replacements),
+                tt->hashfull());
+}
+
+static int runPerft(int depth, const std::string& fen, ThreadPool& pool, TranspositionTable* tt) {
+    Position pos;
+    if (!loadPosition(pos, fen))
+        return EXIT_FAILURE;
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = perftParallel(pos, depth, pool, tt);
+    double seconds = secondsSince(start);
+
+    std::printf("depth %d: %llu nodes, %.3f s, %.0f nps\n", depth,
+                static_cast<unsigned long long>(nodes), seconds, seconds > 0 ? nodes / seconds : 0.0);
+    printHashStats(tt);
+    return EXIT_SUCCESS;
+}
+
+static int runDivide(int depth, const std::string& fen, ThreadPool& pool, TranspositionTable* tt) {
+    Position pos;
+    if (!loadPosition(pos, fen) || depth < 1)
+        return EXIT_FAILURE;
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t total = 0;
+    for (Move m : moves) {
+        Position next = pos;
+        next.makeMove(m);
+        uint64_t nodes = perftParallel(next, depth - 1, pool, tt);
+        total += nodes;
+
+        char uci[6];
+        moveToUci(m, uci);
+        std::printf("%s: %llu\n", uci, static_cast<unsigned long long>(nodes));
+    }
+    double seconds = secondsSince(start);
+
+    std::printf("\nmoves: %d\nnodes: %llu\ntime: %.3f s\nnps: %.0f\n", moves.size(),
+                static_cast<unsigned long long>(total), seconds, seconds > 0 ? total / seconds : 0.0);
+    printHashStats(tt);
+    return EXIT_SUCCESS;
+}
+
+static int runSuite(double minNps, ThreadPool& pool, TranspositionTable* tt) {
+    int passed = 0;
+    int count = 0;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+
+    for (const PerftCase& test : referenceSuite) {
+        ++count;
+        Position pos;
+        if (!loadPosition(pos, test.fen))
+            continue;
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = perftParallel(pos, test.depth, pool, tt);
+        double seconds = secondsSince(start);
+
+        totalNodes += nodes;
+        totalSeconds += seconds;
+        bool ok = nodes == test.nodes;
+        passed += ok;
+
+        std::printf("%-26s depth %d %12llu %s", test.name, test.depth,
+                    static_cast<unsigned long long>(nodes), ok ? "ok  " : "FAIL");
+        if (!ok)
+            std::printf(" (expected %llu)", static_cast<unsigned long long>(test.nodes));
+        std::printf(" %8.3f s\n", seconds);
+    }
+
+    double nps = totalSeconds > 0 ? totalNodes / totalSeconds : 0.0;
+    std::printf("\n%d/%d positions correct, %llu nodes, %.3f s, %.0f nps, %d threads\n", passed, count,
+                static_cast<unsigned long long>(totalNodes), totalSeconds, nps, pool.threadCount());
+    printHashStats(tt);
+
+    if (passed != count)
+        return EXIT_FAILURE;
+    if (minNps > 0 && nps < minNps) {
+        std::printf("speed regression: %.0f nps is below the %.0f nps threshold\n", nps, minNps);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+struct EpdResult {
+    int failedDepth;
+    uint64_t nodes;
+    uint64_t expected;
+};
+
+// One task per EPD line: many small positions balance better across cores
+// than splitting each tree.
+static int runEpd(const std::string& path, int maxDepth, ThreadPool& pool, TranspositionTable* tt) {
+    std::ifstream in(path);
+    if (!in) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[0] != '#')
+            lines.push_back(line);
+    }
+
+    std::vector<EpdResult> results(lines.size(), EpdResult{0, 0, 0});
+    std::atomic<uint64_t> totalNodes(0);
+    TaskGroup group;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lines.size(); ++i) {
+        pool.submit(group, [&, i] {
+            const std::string& entry = lines[i];
+            size_t fenEnd = entry.find(';');
+            Position pos;
+            if (!pos.fromFen(std::string_view(entry).substr(0, fenEnd)).ok()) {
+                results[i].failedDepth = -1;
+                return;
+            }
+
+            // Fields look like ";D3 8902"
+            for (size_t at = fenEnd; at != std::string::npos; at = entry.find(';', at + 1)) {
+                int depth = 0;
+                unsigned long long expected = 0;
+                if (std::sscanf(entry.c_str() + at, ";D%d %llu", &depth, &expected) != 2 || depth > maxDepth)
+                    continue;
+
+                uint64_t nodes = tt ? perft(pos, depth, *tt) : perft(pos, depth);
+                totalNodes.fetch_add(nodes, std::memory_order_relaxed);
+                if (nodes != expected) {
+                    results[i] = EpdResult{depth, nodes, expected};
+                    return;
+                }
+            }
+        });
+    }
+    pool.wait(group);
+    double seconds = secondsSince(start);
+
+    int failures = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const EpdResult& r = results[i];
+        if (r.failedDepth == 0)
+            continue;
+        ++failures;
+        if (r.failedDepth < 0)
+            std::printf("line %zu: invalid FEN\n", i + 1);
+        else
+            std::printf("line %zu: depth %d gave %llu, expected %llu\n", i + 1, r.failedDepth,
+                        static_cast<unsigned long long>(r.nodes), static_cast<unsigned long long>(r.expected));
+    }
+
+    uint64_t nodes = totalNodes.load();
+    std::printf("%zu positions, %d failed, %llu nodes, %.3f s, %.0f nps, %d threads\n", lines.size(), failures,
+                static_cast<unsigned long long>(nodes), seconds, seconds > 0 ? nodes / seconds : 0.0,
+                pool.threadCount());
+    printHashStats(tt);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void printUsage() {
+    std::fprintf(stderr,
+                 "usage: chess_perft <depth> [fen]\n"
+                 "       chess_perft divide <depth> [fen]\n"
+                 "       chess_perft suite [--min-nps N]\n"
+                 "       chess_perft epd <file> [--max-depth D]\n"
+                 "options: --threads N, --hash MB\n");
+}
+
+int main(int argc, char* argv[]) {
+    int threads = ThreadPool::hardwareThreads();
+    double minNps = 0;
+    int maxDepth = 64;
+    int hashMb = 0;
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; ++i) {
+        if ((!std::strcmp(argv[i], "--threads") || !std::strcmp(argv[i], "-t")) && i + 1 < argc)
+            threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--min-nps") && i + 1 < argc)
+            minNps = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--max-depth") && i + 1 < argc)
+            maxDepth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--hash") && i + 1 < argc)
+            hashMb = std::atoi(argv[++i]);
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (args.empty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool(threads);
+    std::unique_ptr<TranspositionTable> tt;
+    if (hashMb > 0)
+        tt.reset(new TranspositionTable(static_cast<size_t>(hashMb)));
+    const std::string& mode = args[0];
+
+    if (mode == "suite")
+        return runSuite(minNps, pool, tt.get());
+
+    if (mode == "divide" || mode == "epd") {
+        if (args.size() < 2) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        if (mode == "epd")
+            return runEpd(args[1], maxDepth, pool, tt.get());
+        return runDivide(std::atoi(args[1].c_str()), joinArgs(args, 2), pool, tt.get());
+    }
+
+    if (mode[0] < '0' || mode[0] > '9') {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    return runPerft(std::atoi(mode.c_str()), joinArgs(args, 1), pool, tt.get());
+}
@@ -0,0 +1,100 @@
+// chess_pgn: replay PGN game databases through the rules core.
+//
+//   chess_pgn <file|->                   replay every game and print totals and
+//                                        throughput; each game that does not
+//                                        replay is reported with its byte offset
+//
+// Totals include the games that reached a draw by rule (stalemate, threefold
+// repetition, the fifty-move rule or insufficient material) by reason,
+// whatever result they record.
+//
+// --threads N sets the number of parsing workers (default: all hardware
+// threads), --unordered lets games be reported in the order they finish and
+// --quiet leaves out the per-game reports. Exits non-zero if any game fails
+// to replay. Memory use does not depend on the size of the file.
+
+#include "PgnIngest.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void printUsage() {
+    std::fprintf(stderr, "usage: chess_pgn <file|-> [--threads N] [--unordered] [--quiet]\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = nullptr;
+    bool quiet = false;
+    PgnIngestOptions options;
+    options.threads = ThreadPool::hardwareThreads();
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--quiet") || !std::strcmp(argv[i], "-q"))
+            quiet = true;
+        else if ((!std::strcmp(argv[i], "--threads") || !std::strcmp(argv[i], "-t")) && i + 1 < argc)
+            options.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--unordered"))
+            options.ordered = false;
+        else if (!path)
+            path = argv[i];
+    }
+    if (!path) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    std::FILE* file = std::strcmp(path, "-") ? std::fopen(path, "rb") : stdin;
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t plies = 0;
+    uint64_t results[4] = {};   // White wins, Black wins, draws, unfinished
+    uint64_t draws[5] = {};     // by DrawReason
+    PgnIngestStats stats = ingestPgn(file, options, [&](const PgnGameSummary& game) {
+        plies += game.plies;
+        ++draws[game.draw];
+        if (!std::strcmp(game.result, "1-0"))
+            ++results[0];
+        else if (!std::strcmp(game.result, "0-1"))
+            ++results[1];
+        else if (!std::strcmp(game.result, "1/2-1/2"))
+            ++results[2];
+        else
+            ++results[3];
+
+        if (game.error && !quiet)
+            std::printf("game at byte %llu, ply %u: %s: %s\n", static_cast<unsigned long long>(game.offset),
+                        game.plies + 1, game.error, game.errorToken);
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (file != stdin)
+        std::fclose(file);
+    if (stats.readError) {
+        std::fprintf(stderr, "error reading %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t games = stats.games;
+    double megabytes = static_cast<double>(stats.bytes) / (1 << 20);
+    std::printf("%llu games, %llu failed, %llu plies, %llu-%llu-%llu, %llu unfinished\n",
+                static_cast<unsigned long long>(games), static_cast<unsigned long long>(stats.failed),
+                static_cast<unsigned long long>(plies), static_cast<unsigned long long>(results[0]),
+                static_cast<unsigned long long>(results[1]), static_cast<unsigned long long>(results[2]),
+                static_cast<unsigned long long>(results[3]));
+    std::printf("drawn by rule: %llu stalemate, %llu repetition, %llu fifty-move, %llu insufficient material\n",
+                static_cast<unsigned long long>(draws[DRAW_STALEMATE]),
+                static_cast<unsigned long long>(draws[DRAW_REPETITION]),
+                static_cast<unsigned long long>(draws[DRAW_FIFTY_MOVES]),
+                static_cast<unsigned long long>(draws[DRAW_INSUFFICIENT_MATERIAL]));
+    std::printf("%.1f MB, %.3f s, %.0f games/s, %.1f MB/s, %d threads\n", megabytes, seconds,
+                seconds > 0 ? games / seconds : 0.0, seconds > 0 ? megabytes / seconds : 0.0, options.threads);
+    return stats.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
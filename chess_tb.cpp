@@ -0,0 +1,264 @@
+// chess_tb: probe Syzygy endgame tablebases and adjudicate games with them.
+//
+//   chess_tb probe <path> <fen>          print the position's WDL and DTZ and
+//                                        the moves that keep its result
+//   chess_tb adjudicate <path> <games|-> [--max-pieces N] [--quiet]
+//                                        replay each game of a PGN file or a
+//                                        chess_gamedb file up to the first
+//                                        position the tables cover and compare
+//                                        the tablebase result with the
+//                                        recorded one
+//   chess_tb selftest <path>             probe KQvK and KRvK positions of known
+//                                        result to check the tables and the
+//                                        decoder
+//
+// path lists the table directories, separated by ':' (';' on Windows). A
+// tablebase win is adjudicated as a draw when the fifty-move rule comes
+// first. Every disagreement is printed unless --quiet is given.
+
+#include "GameFile.h"
+#include "MoveGen.h"
+#include "Pgn.h"
+#include "San.h"
+#include "Tablebases.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static void printUsage() {
+    std::fprintf(stderr, "usage: chess_tb probe <path> <fen>\n"
+                         "       chess_tb adjudicate <path> <games|-> [--max-pieces N] [--quiet]\n"
+                         "       chess_tb selftest <path>\n");
+}
+
+static const char* wdlText(WdlScore wdl) {
+    static const char* const texts[] = {"loss", "blessed loss", "draw", "cursed win", "win"};
+    return texts[wdl + 2];
+}
+
+static bool initTables(Tablebases& tablebases, const char* path, int maxPieces) {
+    if (tablebases.init(path, maxPieces) > 0)
+        return true;
+    std::fprintf(stderr, "no tablebase files found in %s\n", path);
+    return false;
+}
+
+static int probe(const char* path, const char* fen) {
+    Position pos;
+    FenError error = pos.fromFen(fen);
+    if (!error.ok()) {
+        std::fprintf(stderr, "bad FEN: %s\n", error.message);
+        return EXIT_FAILURE;
+    }
+    Tablebases tablebases;
+    if (!initTables(tablebases, path, MAX_TB_PIECES))
+        return EXIT_FAILURE;
+
+    WdlScore wdl;
+    int dtz;
+    auto start = std::chrono::steady_clock::now();
+    if (!tablebases.probeWdl(pos, wdl)) {
+        std::fprintf(stderr, "position not in the tables\n");
+        return EXIT_FAILURE;
+    }
+    bool haveDtz = tablebases.probeDtz(pos, dtz);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("wdl %s", wdlText(wdl));
+    if (haveDtz)
+        std::printf(", dtz %d", dtz);
+    std::printf(" (%.1f us)\n", us);
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (haveDtz && tablebases.filterRootMoves(pos, moves)) {
+        std::printf("best:");
+        for (Move m : moves) {
+            char san[16];
+            moveToSan(pos, m, san);
+            std::printf(" %s", san);
+        }
+        std::printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+struct Adjudication {
+    uint64_t games = 0;
+    uint64_t adjudicated = 0;
+    uint64_t agreed = 0;
+    uint64_t disagreed = 0;
+    uint64_t pliesSaved = 0;
+    uint64_t probes = 0;
+    double probeSeconds = 0;
+};
+
+// The result of pos with the best play the tables know, under the
+// fifty-move rule; false if pos is not covered or a table is missing.
+static bool tablebaseResult(const Tablebases& tablebases, const Position& pos, GameResult& result,
+                            Adjudication& stats) {
+    auto start = std::chrono::steady_clock::now();
+    WdlScore wdl;
+    bool ok = tablebases.probeWdl(pos, wdl);
+    int dtz;
+    if (ok && (wdl == WDL_WIN || wdl == WDL_LOSS) && tablebases.probeDtz(pos, dtz)
+        && std::abs(dtz) + pos.halfmoveClock() > 100)
+        wdl = WDL_DRAW;
+    stats.probeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++stats.probes;
+    if (!ok)
+        return false;
+
+    if (wdl == WDL_WIN || wdl == WDL_LOSS)
+        result = (wdl == WDL_WIN) == (pos.sideToMove() == WHITE) ? WHITE_WINS : BLACK_WINS;
+    else
+        result = DRAW;
+    return true;
+}
+
+static void adjudicateGame(const Tablebases& tablebases, const Position& start, const std::vector<Move>& moves,
+                           GameResult recorded, bool quiet, Adjudication& stats) {
+    uint64_t game = stats.games++;
+    Position pos = start;
+    for (size_t ply = 0; ply <= moves.size(); ++ply) {
+        GameResult result;
+        if (tablebases.covers(pos) && tablebaseResult(tablebases, pos, result, stats)) {
+            ++stats.adjudicated;
+            stats.pliesSaved += moves.size() - ply;
+            if (result == recorded) {
+                ++stats.agreed;
+            } else {
+                ++stats.disagreed;
+                if (!quiet) {
+                    char fen[MAX_FEN_LENGTH];
+                    pos.toFen(fen);
+                    std::printf("game %llu: recorded %s, tablebase %s at ply %zu: %s\n",
+                                static_cast<unsigned long long>(game), resultText(recorded), resultText(result),
+                                ply, fen);
+                }
+            }
+            return;
+        }
+        if (ply < moves.size())
+            pos.makeMove(moves[ply]);
+    }
+}
+
+static int adjudicate(const char* path, const char* games, int maxPieces, bool quiet) {
+    Tablebases tablebases;
+    if (!initTables(tablebases, path, maxPieces))
+        return EXIT_FAILURE;
+
+    auto start = std::chrono::steady_clock::now();
+    Adjudication stats;
+
+    GameFile file;
+    uint64_t skipped = 0;
+    if (std::strcmp(games, "-") && file.open(games)) {
+        GameRecord record;
+        for (uint64_t i = 0; i < file.gameCount(); ++i) {
+            if (file.readGame(i, record))
+                adjudicateGame(tablebases, record.start, record.moves, record.result, quiet, stats);
+            else
+                ++skipped;
+        }
+    } else {
+        std::FILE* in = std::strcmp(games, "-") ? std::fopen(games, "rb") : stdin;
+        if (!in) {
+            std::fprintf(stderr, "cannot open %s\n", games);
+            return EXIT_FAILURE;
+        }
+        PgnReader reader(in);
+        PgnGame game;
+        while (reader.next(game)) {
+            if (game.ok())
+                adjudicateGame(tablebases, game.start, game.moves, parseResult(game.result), quiet, stats);
+            else
+                ++skipped;
+        }
+        if (in != stdin)
+            std::fclose(in);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%llu games, %llu skipped, %llu adjudicated: %llu agree, %llu disagree\n",
+                static_cast<unsigned long long>(stats.games), static_cast<unsigned long long>(skipped),
+                static_cast<unsigned long long>(stats.adjudicated), static_cast<unsigned long long>(stats.agreed),
+                static_cast<unsigned long long>(stats.disagreed));
+    std::printf("%llu plies after adjudication, %llu probes, %.1f us per probe, %.3f s\n",
+                static_cast<unsigned long long>(stats.pliesSaved), static_cast<unsigned long long>(stats.probes),
+                stats.probes ? stats.probeSeconds * 1e6 / stats.probes : 0.0, seconds);
+    return EXIT_SUCCESS;
+}
+
+// Positions with their WDL and DTZ from the side to move. Without pawns a
+// win only zeroes the counter by mating, so the DTZ of these is the mate
+// distance in plies, which the search confirms independently.
+struct TbCase {
+    const char* fen;
+    WdlScore wdl;
+    int dtz;
+};
+
+static const TbCase knownResults[] = {
+    {"8/8/8/3k4/8/8/8/KQ6 w - - 0 1", WDL_WIN, 17},
+    {"7k/8/8/8/8/8/8/KQ6 w - - 0 1", WDL_WIN, 13},
+    {"8/3k4/8/3K4/8/8/8/7Q b - - 0 1", WDL_LOSS, -8},
+    {"k7/1Q6/1K6/8/8/8/8/8 b - - 0 1", WDL_LOSS, -1},      // checkmated
+    {"k7/2Q5/1K6/8/8/8/8/8 b - - 0 1", WDL_DRAW, 0},       // stalemate
+    {"8/8/8/8/8/8/1k6/Q6K b - - 0 1", WDL_DRAW, 0},        // the queen falls
+    {"k7/8/1K6/8/8/8/8/7R w - - 0 1", WDL_WIN, 1},
+    {"3k4/8/8/3K4/8/8/8/7R w - - 0 1", WDL_WIN, 5},
+    {"3k4/8/8/3K4/8/8/8/7R b - - 0 1", WDL_LOSS, -16},
+    {"8/8/3k4/8/3K4/8/8/7R w - - 0 1", WDL_WIN, 19},
+    {"8/8/8/8/8/8/1k6/R6K b - - 0 1", WDL_DRAW, 0},        // the rook falls
+};
+
+// Catches a decoder that only agrees with tables written by its own index code
+static int selfTest(const char* path) {
+    Tablebases tablebases;
+    if (!initTables(tablebases, path, 3))
+        return EXIT_FAILURE;
+
+    int failed = 0;
+    for (const TbCase& test : knownResults) {
+        Position pos;
+        pos.fromFen(test.fen);
+        WdlScore wdl;
+        int dtz;
+        if (!tablebases.probeWdl(pos, wdl) || !tablebases.probeDtz(pos, dtz)) {
+            std::printf("%s: not in the tables\n", test.fen);
+            ++failed;
+        } else if (wdl != test.wdl || dtz != test.dtz) {
+            std::printf("%s: wdl %s, dtz %d, expected wdl %s, dtz %d\n", test.fen, wdlText(wdl), dtz,
+                        wdlText(test.wdl), test.dtz);
+            ++failed;
+        }
+    }
+    int total = static_cast<int>(sizeof(knownResults) / sizeof(knownResults[0]));
+    std::printf("%d/%d positions correct\n", total - failed, total);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && !std::strcmp(argv[1], "probe"))
+        return probe(argv[2], argv[3]);
+    if (argc >= 4 && !std::strcmp(argv[1], "adjudicate")) {
+        int maxPieces = MAX_TB_PIECES;
+        bool quiet = false;
+        for (int i = 4; i < argc; ++i) {
+            if (!std::strcmp(argv[i], "--max-pieces") && i + 1 < argc)
+                maxPieces = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i], "--quiet"))
+                quiet = true;
+        }
+        return adjudicate(argv[2], argv[3], maxPieces, quiet);
+    }
+    if (argc >= 3 && !std::strcmp(argv[1], "selftest"))
+        return selfTest(argv[2]);
+    printUsage();
+    return EXIT_FAILURE;
+}
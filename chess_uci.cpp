@@ -0,0 +1,291 @@
+// chess_uci: the engine as a UCI console program, for tournament managers
+// and match scripts.
+//
+// Understands uci, isready, ucinewgame, setoption (Hash, Threads,
+// SyzygyPath), position startpos|fen <fen> [moves ...], go (depth, nodes,
+// movetime, wtime, btime, winc, binc, movestogo, infinite), stop and quit.
+// Each completed iteration prints an info line with nps and hashfull.
+//
+// The search runs on its own thread and this one keeps reading commands,
+// so stop reaches it while it thinks; it ends within a few hundred nodes
+// and prints bestmove itself.
+
+#include "MoveGen.h"
+#include "Search.h"
+#include "Tablebases.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int DEFAULT_HASH_MB = 16;
+const int MAX_HASH_MB = 65536;
+const int MAX_THREADS = 256;
+
+// Both threads write to stdout, a line at a time
+std::mutex outputMutex;
+
+void sendLine(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::fputs(line.c_str(), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+std::string scoreText(int score) {
+    if (std::abs(score) >= VALUE_MATE_IN_MAX_PLY) {
+        int plies = VALUE_MATE - std::abs(score);
+        int moves = (plies + 1) / 2;
+        return "mate " + std::to_string(score > 0 ? moves : -moves);
+    }
+    return "cp " + std::to_string(score);
+}
+
+std::string uciText(Move m) {
+    char uci[6];
+    moveToUci(m, uci);
+    return uci;
+}
+
+Move parseUciMove(const Position& pos, const std::string& text) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    for (Move m : moves)
+        if (uciText(m) == text)
+            return m;
+    return Move();
+}
+
+class UciEngine {
+public:
+    UciEngine() : m_table(DEFAULT_HASH_MB), m_search(m_table), m_searching(false), m_stopRequested(false) {
+        m_root.setStartPosition();
+    }
+
+    ~UciEngine() { stop(); }
+
+    void loop();
+
+private:
+    void setOption(std::istringstream& in);
+    void setPosition(std::istringstream& in);
+    void go(std::istringstream& in);
+    void stop();
+    void think(SearchLimits limits, bool infinite, uint64_t stopsSeen);
+
+    TranspositionTable m_table;
+    Search m_search;
+    Tablebases m_tablebases;
+
+    Position m_root;
+    std::vector<uint64_t> m_history;   // keys before the root, oldest first
+
+    std::thread m_thread;
+    bool m_searching;
+    // Guards m_stopRequested, which lets an infinite search hold its
+    // bestmove until stop
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
+    bool m_stopRequested;
+};
+
+void UciEngine::loop() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+
+        if (command == "uci") {
+            sendLine("id name Chess");
+            sendLine("id author Chess contributors");
+            sendLine("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max "
+                     + std::to_string(MAX_HASH_MB));
+            sendLine("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+            sendLine("option name SyzygyPath type string default <empty>");
+            sendLine("uciok");
+        } else if (command == "isready") {
+            sendLine("readyok");
+        } else if (command == "ucinewgame") {
+            stop();
+            m_table.clear();
+            m_search.clear();
+        } else if (command == "setoption") {
+            setOption(in);
+        } else if (command == "position") {
+            stop();
+            setPosition(in);
+        } else if (command == "go") {
+            go(in);
+        } else if (command == "stop") {
+            stop();
+        } else if (command == "quit") {
+            break;
+        } else if (!command.empty()) {
+            sendLine("info string unknown command " + command);
+        }
+    }
+    stop();
+}
+
+void UciEngine::setOption(std::istringstream& in) {
+    std::string word, name, value;
+    in >> word;   // "name"
+    while (in >> word && word != "value")
+        name += (name.empty() ? "" : " ") + word;
+    std::getline(in >> std::ws, value);
+
+    // Tables and threads are not changed under a running search
+    stop();
+    if (name == "Hash") {
+        m_table.resize(std::clamp(std::atoi(value.c_str()), 1, MAX_HASH_MB));
+    } else if (name == "Threads") {
+        m_search.setThreads(std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS));
+    } else if (name == "SyzygyPath") {
+        m_search.setTablebases(nullptr);
+        m_tablebases.clear();
+        if (!value.empty() && value != "<empty>" && m_tablebases.init(value) > 0) {
+            m_search.setTablebases(&m_tablebases);
+            sendLine("info string " + std::to_string(m_tablebases.tableCount()) + " tablebases found");
+        }
+    } else {
+        sendLine("info string unknown option " + name);
+    }
+}
+
+void UciEngine::setPosition(std::istringstream& in) {
+    std::string word;
+    in >> word;
+    Position pos;
+    if (word == "startpos") {
+        pos.setStartPosition();
+        in >> word;
+    } else if (word == "fen") {
+        std::string fen;
+        while (in >> word && word != "moves")
+            fen += (fen.empty() ? "" : " ") + word;
+        FenError error = pos.fromFen(fen);
+        if (!error.ok()) {
+            sendLine(std::string("info string bad FEN: ") + error.message);
+            return;
+        }
+    } else {
+        return;
+    }
+
+    m_history.clear();
+    if (word == "moves") {
+        while (in >> word) {
+            Move m = parseUciMove(pos, word);
+            if (m.isNull()) {
+                sendLine("info string illegal move " + word);
+                break;
+            }
+            m_history.push_back(pos.key());
+            pos.makeMove(m);
+        }
+    }
+    m_root = pos;
+}
+
+void UciEngine::go(std::istringstream& in) {
+    stop();
+
+    SearchLimits limits;
+    bool infinite = false;
+    std::string word;
+    while (in >> word) {
+        if (word == "infinite") {
+            infinite = true;
+            continue;
+        }
+        // Pondering is not supported; a ponder search is an ordinary one
+        if (word == "ponder")
+            continue;
+        long long value = 0;
+        if (!(in >> value))
+            break;
+        if (word == "depth")
+            limits.depth = static_cast<int>(std::min<long long>(value, MAX_PLY - 1));
+        else if (word == "nodes")
+            limits.nodes = static_cast<uint64_t>(std::max(0LL, value));
+        else if (word == "movetime")
+            limits.moveTimeMs = static_cast<int>(value);
+        else if (word == "wtime")
+            limits.timeLeftMs[WHITE] = static_cast<int>(value);
+        else if (word == "btime")
+            limits.timeLeftMs[BLACK] = static_cast<int>(value);
+        else if (word == "winc")
+            limits.incrementMs[WHITE] = static_cast<int>(value);
+        else if (word == "binc")
+            limits.incrementMs[BLACK] = static_cast<int>(value);
+        else if (word == "movestogo")
+            limits.movesToGo = static_cast<int>(value);
+    }
+    if (infinite)
+        limits = SearchLimits();
+
+    m_stopRequested = false;
+    m_searching = true;
+    // A stop that comes before the thread reaches run() still ends the search
+    uint64_t stopsSeen = m_search.stopRequests();
+    m_thread = std::thread([this, limits, infinite, stopsSeen] { think(limits, infinite, stopsSeen); });
+}
+
+// Runs on the search thread
+void UciEngine::think(SearchLimits limits, bool infinite, uint64_t stopsSeen) {
+    m_search.setInfoCallback([this](const SearchInfo& si) {
+        uint64_t nps = si.timeMs > 0 ? si.nodes * 1000 / static_cast<uint64_t>(si.timeMs) : si.nodes * 1000;
+        std::string line = "info depth " + std::to_string(si.depth) + " seldepth " + std::to_string(si.selDepth)
+                           + " score " + scoreText(si.score) + " nodes " + std::to_string(si.nodes) + " nps "
+                           + std::to_string(nps) + " hashfull " + std::to_string(m_table.hashfull()) + " tbhits "
+                           + std::to_string(si.tbHits) + " time " + std::to_string(si.timeMs) + " pv";
+        for (Move m : si.pv)
+            line += " " + uciText(m);
+        sendLine(line);
+    });
+
+    SearchResult result = m_search.run(m_root, limits, m_history, stopsSeen);
+
+    // UCI wants no bestmove for an infinite search before stop
+    if (infinite) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopped.wait(lock, [this] { return m_stopRequested; });
+    }
+
+    std::string line = "bestmove " + (result.bestMove.isNull() ? std::string("0000") : uciText(result.bestMove));
+    if (!result.ponderMove.isNull())
+        line += " ponder " + uciText(result.ponderMove);
+    sendLine(line);
+}
+
+void UciEngine::stop() {
+    if (!m_searching)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_search.stop();
+    m_stopped.notify_all();
+    m_thread.join();
+    m_searching = false;
+}
+
+} // namespace
+
+int main() {
+    UciEngine engine;
+    engine.loop();
+    return EXIT_SUCCESS;
+}
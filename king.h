@@ -8,7 +8,6 @@
 class King : public ChessPiece {
 public:
     King(PieceColor color, int row, int col);
-    QVector<QPair<int, int>> getValidMoves(const QVector<QVector<ChessPiece*>> &board) override;
 };
 
 #endif // KING_H
@@ -8,7 +8,6 @@
 class Knight : public ChessPiece {
 public:
     Knight(PieceColor color, int row, int col);
-    QVector<QPair<int, int>> getValidMoves(const QVector<QVector<ChessPiece*>> &board) override;
 };
 
 #endif // KNIGHT_H
@@ -1,11 +1,16 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include <QCoreApplication>
 #include <QMessageBox>
 #include <QLabel>
 #include <QPixmap>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QSpacerItem>
+#include "San.h"
+
+// Thinking time per engine move
+static const int ENGINE_MOVE_TIME_MS = 1000;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -68,8 +73,43 @@ MainWindow::MainWindow(QWidget *parent)
         "QPushButton:hover { background-color: #e69500; }"
         );
 
-    // Disable abandon button initially until game starts
+    ui->takeBackButton->setStyleSheet(
+        "QPushButton {"
+        " background-color: #607d8b;"
+        " color: white;"
+        " font-weight: bold;"
+        " font-size: 16px;"
+        " padding: 10px 20px;"
+        " border-radius: 8px;"
+        " }"
+        "QPushButton:hover { background-color: #546e7a; }"
+        );
+
+    ui->engineCheckBox->setStyleSheet(
+        "QCheckBox {"
+        " color: #2c3e50;"
+        " font-weight: bold;"
+        " font-size: 16px;"
+        " }"
+        );
+
+    // 🔹 Engine searches on its own thread; results arrive as queued signals
+    engine = new EngineController(this);
+
+    // 🔹 Opening book next to the executable, if there is one
+    QString bookPath = QCoreApplication::applicationDirPath() + "/book.bin";
+    if (book.open(bookPath.toLocal8Bit().constData()))
+        engine->setBookFile(bookPath);
+
+    // 🔹 Endgame tablebases from SYZYGY_PATH, or a syzygy folder next to the executable
+    QString tablebasePath = qEnvironmentVariable("SYZYGY_PATH");
+    if (tablebasePath.isEmpty())
+        tablebasePath = QCoreApplication::applicationDirPath() + "/syzygy";
+    engine->setTablebasePath(tablebasePath);
+
+    // Disable abandon and take back buttons initially until game starts
     ui->abandonButton->setEnabled(false);
+    ui->takeBackButton->setEnabled(false);
 
     // 🔹 Modern Status Label
     ui->statusLabel->setAlignment(Qt::AlignCenter);
@@ -78,13 +118,24 @@ MainWindow::MainWindow(QWidget *parent)
     // 🔹 Signal-Slot Connections
     connect(ui->startButton, &QPushButton::clicked, this, &MainWindow::onStartGame);
     connect(ui->abandonButton, &QPushButton::clicked, this, &MainWindow::onAbandonGame);
+    connect(ui->takeBackButton, &QPushButton::clicked, this, &MainWindow::onTakeBack);
     connect(chessBoard, &Board::turnChanged, this, &MainWindow::onTurnChanged);
     connect(chessBoard, &Board::checkmate, this, &MainWindow::onCheckmate);
+    connect(chessBoard, &Board::stalemate, this, &MainWindow::onStalemate);
+    connect(chessBoard, &Board::drawByRepetition, this, &MainWindow::onDrawByRepetition);
+    connect(chessBoard, &Board::drawByFiftyMoves, this, &MainWindow::onDrawByFiftyMoves);
+    connect(chessBoard, &Board::drawByInsufficientMaterial, this, &MainWindow::onDrawByInsufficientMaterial);
+    connect(chessBoard, &Board::movePlayed, this, &MainWindow::onMovePlayed);
+    connect(ui->engineCheckBox, &QCheckBox::toggled, this, &MainWindow::onEngineToggled);
+    connect(engine, &EngineController::moveFound, this, &MainWindow::onEngineMove);
+    connect(engine, &EngineController::searchInfo, this, &MainWindow::onEngineInfo);
 
     onTurnChanged(chessBoard->getCurrentPlayer());
 }
 
 MainWindow::~MainWindow() {
+    // Join the engine thread before the board it may report to goes away
+    delete engine;
     delete chessBoard;
     delete ui;
 }
@@ -122,6 +173,8 @@ void MainWindow::updateStatusLabel(const QString& text,
 }
 
 void MainWindow::onStartGame() {
+    engine->newGame();
+    gameInProgress = true;
     ui->graphicsView->setEnabled(true);
     chessBoard->clear();
     chessBoard->setupInitialPosition();
@@ -130,6 +183,8 @@ void MainWindow::onStartGame() {
     updateStatusLabel("Game Started ✅", "green", "#eafaf1", "green", 20, 2, 10, 10, 700);
 
     ui->abandonButton->setEnabled(true);
+    ui->takeBackButton->setEnabled(true);
+    startEngineIfDue();
 }
 
 void MainWindow::onAbandonGame() {
@@ -137,22 +192,71 @@ void MainWindow::onAbandonGame() {
     if (reply != QMessageBox::Yes)
         return;
 
+    engine->cancel();
+    gameInProgress = false;
     chessBoard->clear();
     ui->graphicsView->setEnabled(false);
+    ui->graphicsView->setInteractive(true);
 
     updateStatusLabel("Game Restarted 🔄", "orange", "#fff3e0", "orange", 20, 2, 10, 10, 700);
 
     QMessageBox::information(this, "Game Restarted", "The game has been reset.");
 
     ui->abandonButton->setEnabled(false);
+    ui->takeBackButton->setEnabled(false);
+}
+
+void MainWindow::onTakeBack() {
+    engine->cancel();
+    if (chessBoard->takeBack()) {
+        // Against the engine, go back to the player's own previous move
+        if (ui->engineCheckBox->isChecked() && chessBoard->getCurrentPlayer() == ChessPiece::Black)
+            chessBoard->takeBack();
+
+        // A takeback also reopens a game that had ended in checkmate or a draw
+        gameInProgress = true;
+        ui->graphicsView->setEnabled(true);
+        ui->abandonButton->setEnabled(true);
+    }
+    startEngineIfDue();
 }
 
 void MainWindow::onTurnChanged(ChessPiece::PieceColor player) {
     QString playerText = (player == ChessPiece::PieceColor::White) ? "White" : "Black";
-    updateStatusLabel(playerText + "'s Turn ⚔️", "#2c3e50", "#ecf0f1", "#bdc3c7", 20, 2, 10, 10, 700);
+    QString text = playerText + "'s Turn ⚔️";
+
+    // Suggest book moves to a human player only
+    bool engineToMove = ui->engineCheckBox->isChecked() && player == ChessPiece::Black;
+    QString suggestions = engineToMove ? QString() : bookSuggestions();
+    if (!suggestions.isEmpty())
+        text += "\n📖 " + suggestions;
+    updateStatusLabel(text, "#2c3e50", "#ecf0f1", "#bdc3c7", 20, 2, 10, 10, 700);
+}
+
+QString MainWindow::bookSuggestions() const {
+    BookMove moves[MAX_BOOK_MOVES];
+    const Position& pos = chessBoard->getPosition();
+    int count = book.probe(pos, moves);
+    int total = 0;
+    for (int i = 0; i < count; ++i)
+        total += moves[i].weight;
+    if (total == 0)
+        return QString();
+
+    QString text;
+    for (int i = 0; i < count && i < 3 && moves[i].weight > 0; ++i) {
+        char san[MAX_SAN_LENGTH];
+        moveToSan(pos, moves[i].move, san);
+        if (!text.isEmpty())
+            text += "  ";
+        text += QString("%1 %2%").arg(QString(san)).arg(100 * moves[i].weight / total);
+    }
+    return text;
 }
 
 void MainWindow::onCheckmate(ChessPiece::PieceColor loser) {
+    engine->cancel();
+    gameInProgress = false;
     QString winnerText = (loser == ChessPiece::PieceColor::White) ? "Black" : "White";
     QString resultMsg = "🏆 " + winnerText + " Wins\n" ;
 
@@ -171,3 +275,70 @@ void MainWindow::onCheckmate(ChessPiece::PieceColor loser) {
     ui->graphicsView->setEnabled(false);
     ui->abandonButton->setEnabled(false);
 }
+
+void MainWindow::onStalemate(ChessPiece::PieceColor player) {
+    QString playerText = (player == ChessPiece::PieceColor::White) ? "White" : "Black";
+    announceDraw("Stalemate!", playerText + " has no legal move");
+}
+
+void MainWindow::onDrawByRepetition() {
+    announceDraw("Draw by Repetition", "The same position occurred three times");
+}
+
+void MainWindow::onDrawByFiftyMoves() {
+    announceDraw("Fifty-Move Rule", "Fifty moves each without a capture or pawn move");
+}
+
+void MainWindow::onDrawByInsufficientMaterial() {
+    announceDraw("Insufficient Material", "Neither side has enough material to mate");
+}
+
+void MainWindow::announceDraw(const QString& title, const QString& reason) {
+    engine->cancel();
+    gameInProgress = false;
+    updateStatusLabel("🤝 Draw\n" + reason, "#ecf0f1", "#34495e", "#2c3e50", 22, 3, 15, 15, 800);
+
+    QMessageBox msgBox;
+    msgBox.setWindowTitle("🤝 " + title);
+    msgBox.setText(
+        "<div style='color:#2980b9; font-size:28px; font-weight:bold;'>DRAW 🤝</div>"
+        "<div style='font-size:20px; color:#2c3e50;'>" + reason + "</div>"
+        );
+    msgBox.exec();
+
+    ui->graphicsView->setEnabled(false);
+    ui->abandonButton->setEnabled(false);
+}
+
+void MainWindow::startEngineIfDue() {
+    bool engineToMove = gameInProgress && ui->engineCheckBox->isChecked()
+                        && chessBoard->getCurrentPlayer() == ChessPiece::Black;
+
+    // The view keeps painting while it ignores clicks, so the board stays live
+    ui->graphicsView->setInteractive(!engineToMove);
+    if (engineToMove)
+        engine->think(chessBoard->getPosition(), ENGINE_MOVE_TIME_MS, chessBoard->getGameKeys());
+}
+
+void MainWindow::onMovePlayed(Move) {
+    // Whatever the engine was working on no longer matches the board
+    engine->cancel();
+    startEngineIfDue();
+}
+
+void MainWindow::onEngineToggled(bool) {
+    engine->cancel();
+    startEngineIfDue();
+}
+
+void MainWindow::onEngineMove(Move move) {
+    ui->graphicsView->setInteractive(true);
+    // A null move means the engine had nothing to play
+    chessBoard->playExternalMove(move);
+}
+
+void MainWindow::onEngineInfo(int depth, int score, quint64 nodes) {
+    QString scoreText = QString::number(score / 100.0, 'f', 2);
+    updateStatusLabel(QString("Engine thinking 🤔\nDepth %1  Eval %2\n%3 nodes").arg(depth).arg(scoreText).arg(nodes),
+                      "#2c3e50", "#ecf0f1", "#bdc3c7", 18, 2, 10, 10, 700);
+}
@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include "Board.h"
+#include "Book.h"
+#include "EngineController.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -19,12 +21,31 @@ public:
 private slots:
     void onStartGame();
     void onAbandonGame();
+    void onTakeBack();
     void onTurnChanged(ChessPiece::PieceColor player);
     void onCheckmate(ChessPiece::PieceColor loser);
+    void onStalemate(ChessPiece::PieceColor player);
+    void onDrawByRepetition();
+    void onDrawByFiftyMoves();
+    void onDrawByInsufficientMaterial();
+    void onMovePlayed(Move move);
+    void onEngineToggled(bool enabled);
+    void onEngineMove(Move move);
+    void onEngineInfo(int depth, int score, quint64 nodes);
 
 private:
     Ui::MainWindow *ui;
     Board* chessBoard;   // Make this a member variable!
+    EngineController* engine;
+    Book book;           // opening suggestions; also played by the engine
+    bool gameInProgress = false;
+
+    // Ask the engine for a move if it plays the side to move
+    void startEngineIfDue();
+    // The book's moves for the board position with their shares, or empty
+    QString bookSuggestions() const;
+    // End the game as drawn and say why
+    void announceDraw(const QString& title, const QString& reason);
 private:
     void updateStatusLabel(const QString& text,
                            const QString& color,
@@ -8,7 +8,6 @@
 class Queen : public ChessPiece {
 public:
     Queen(PieceColor color, int row, int col);
-    QVector<QPair<int, int>> getValidMoves(const QVector<QVector<ChessPiece*>> &board) override;
 };
 
 #endif // QUEEN_H
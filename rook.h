@@ -8,7 +8,6 @@
 class Rook : public ChessPiece {
 public:
     Rook(PieceColor color, int row, int col);
-    QVector<QPair<int, int>> getValidMoves(const QVector<QVector<ChessPiece*>> &board) override;
 };
 
 #endif // ROOK_H